@@ -0,0 +1,46 @@
+#pragma once
+#include "Collision/AABB.h"
+#include "Physics/RigidBody.h"
+#include <vector>
+#include <memory>
+
+enum class BroadphaseType {
+    QUADTREE,
+    SWEEP_AND_PRUNE,
+    SPATIAL_HASH,
+    DYNAMIC_AABB_TREE,
+    LINEAR_QUADTREE,
+    LOOSE_QUADTREE
+};
+
+struct BroadphasePair {
+    RigidBody *bodyA;      // Sempre bodyA < bodyB, come nel loop sul QuadTree
+    RigidBody *bodyB;
+};
+
+class Broadphase {
+protected:
+    float margin;          // Allargamento delle AABB: le coppie restano valide per tutte le iterazioni del solver
+
+    Broadphase(float margin);
+
+public:
+    virtual ~Broadphase();
+
+    // Sincronizza la struttura con i corpi del mondo (nuovi, rimossi o spostati)
+    virtual void Update(const std::vector<RigidBody *> &bodies) = 0;
+
+    // Coppie candidate con AABB (allargate di margin) sovrapposte, calcolate sull'ultimo Update.
+    // Lista piatta e senza duplicati: il vettore viene svuotato e riempito.
+    virtual void FindPairs(std::vector<BroadphasePair> &pairs) = 0;
+
+    // Aggiunge in coda a found i corpi la cui AABB (allargata di margin) si
+    // sovrappone a range, ognuno una sola volta. Non alloca a regime.
+    virtual void Query(const AABB &range, std::vector<RigidBody *> &found) = 0;
+
+    void SetMargin(float newMargin) { margin = newMargin; }
+    float GetMargin() const { return margin; }
+
+    // AABB di un corpo secondo la sua forma, allargata di margin su ogni lato
+    static AABB GetBodyBounds(const RigidBody *body, float margin = 0.0f);
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "Physics/RigidBody.h"
+#include "Core/CpuFeatures.h"
+#include <vector>
+#include <cstdint>
+
+// Coppie cerchio-cerchio raccolte in array separati (SoA), una corsia per coppia
+struct CircleBatch {
+    std::vector<float> ax, ay, ar;
+    std::vector<float> bx, by, br;
+
+    void Clear();
+    void Add(const RigidBody *a, const RigidBody *b);
+    size_t Size() const { return ax.size(); }
+};
+
+// Filtro a lotti delle coppie cerchio-cerchio del broadphase: solo il test
+// sul quadrato della distanza, 4 (SSE2) o 8 (AVX) corsie per istruzione,
+// senza radici ne normali. Non e una narrowphase: il solver ricalcola il
+// contatto a ogni iterazione con CircleVsCircle, sulle coppie rimaste.
+class CircleBatchKernel {
+public:
+    // lanes viene svuotato e riempito con le corsie che possono avere una
+    // penetrazione oltre CollisionDetection::circleContactThreshold spostandosi
+    // di al massimo slack, in ordine crescente.
+    static void Prune(const CircleBatch &batch, std::vector<uint32_t> &lanes, float slack = 0.0f);
+    static void Prune(const CircleBatch &batch, std::vector<uint32_t> &lanes, SimdLevel level, float slack = 0.0f);
+};
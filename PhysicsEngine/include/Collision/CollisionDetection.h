@@ -1,5 +1,6 @@
 #pragma once
 #include "Physics/RigidBody.h"
+#include "Collision/AABB.h"
 
 struct CollisionInfo {
     RigidBody *bodyA;
@@ -9,10 +10,38 @@ struct CollisionInfo {
     bool hasCollision;     // Se c' davvero collisione
 };
 
+struct RaycastHit {
+    RigidBody *body;
+    Vector2 point;         // Punto di ingresso nella forma
+    Vector2 normal;        // Normale della superficie colpita
+    float fraction;        // Lungo il segmento: 0 = origine, 1 = fine
+};
+
 class CollisionDetection {
 public:
+    static constexpr float circleContactThreshold = 0.001f;  // Ignora micro-sovrapposizioni
+
     static bool CircleVsCircle(RigidBody *a, RigidBody *b, CollisionInfo &info);
     static bool CircleVsGround(RigidBody *circle, float groundY, CollisionInfo &info);
     static bool CircleVsAABB(RigidBody *circle, RigidBody *aabb, CollisionInfo &info);
     static bool AABBvsAABB(RigidBody *a, RigidBody *b, CollisionInfo &info);
+
+    // Test esatti per le query spaziali (bordi inclusi)
+    static bool PointInBody(const Vector2 &point, const RigidBody *body);
+    static bool CircleOverlapsBody(const Vector2 &center, float radius, const RigidBody *body);
+    static bool AABBOverlapsBody(const AABB &box, const RigidBody *body);
+
+    // Segmento origin -> end contro la forma del corpo. Un'origine interna
+    // colpisce subito (fraction 0) con normale opposta alla direzione.
+    static bool RayVsBody(const Vector2 &origin, const Vector2 &end, RigidBody *body, RaycastHit &hit);
+
+    // Corpo moving spostato da from a to contro other fermo (CCD). hit.point e
+    // la posizione di moving all'impatto, hit.normal esce da other. Se all'inizio
+    // si toccano gia non c'e impatto: ci pensa la collisione discreta.
+    static bool SweepBody(const RigidBody *moving, const Vector2 &from, const Vector2 &to, RigidBody *other, RaycastHit &hit);
+
+private:
+    // Raggio origin + t*d, t in [0, 1], contro un cerchio o un box dato dagli estremi
+    static bool RayVsCircle(const Vector2 &origin, const Vector2 &d, const Vector2 &center, float radius, float &t, Vector2 &normal);
+    static bool RayVsBox(const Vector2 &origin, const Vector2 &d, const Vector2 &min, const Vector2 &max, float &t, Vector2 &normal);
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include "Collision/Narrowphase.h"
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+// Contatto ricordato tra uno step e l'altro, per coppia di corpi
+struct CachedContact {
+    Vector2 normal;            // Ultima normale vista (da A verso B)
+    float accumulated;         // Correzione totale applicata nello step corrente
+    float previous;            // Totale dello step precedente: il warm start
+    unsigned int lastTouched;  // Ultimo step in cui la coppia era in contatto
+    unsigned int age;          // Step consecutivi in contatto
+};
+
+// Cache persistente dei contatti, indicizzata per coppia (bodyA, bodyB) come
+// arriva dai PairBuckets. Durante lo step ogni coppia candidata ha uno slot
+// (pairIndex di PairBuckets) che punta direttamente alla sua voce: il solver
+// non fa lookup nella hash map. Le voci non toccate nell'ultimo step spariscono.
+// I contatti nuovi restano in un array per slot fino a EndStep: durante lo step
+// la map non cambia e coppie diverse si aggiornano da thread diversi.
+class ContactCache {
+private:
+    struct Key {
+        RigidBody *bodyA;
+        RigidBody *bodyB;
+        bool operator==(const Key &other) const { return bodyA == other.bodyA && bodyB == other.bodyB; }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    // I puntatori agli elementi di unordered_map restano validi fino all'erase
+    std::unordered_map<Key, CachedContact, KeyHash> contacts;
+    std::vector<CachedContact *> slots;         // Per pairIndex, nullptr se non in cache
+    std::vector<BroadphasePair> slotPairs;      // Coppia di ogni slot, per creare la voce in EndStep
+    std::vector<CachedContact> fresh;           // Per pairIndex: contatti nati in questo step
+    unsigned int stamp;
+
+public:
+    ContactCache();
+
+    // Inizio step: collega ogni coppia candidata alla sua voce e sposta il
+    // totale dello step precedente in previous
+    void BeginStep(const PairBuckets &pairs);
+
+    // Registra una correzione applicata alla coppia pairIndex. Ritorna true
+    // la prima volta nello step (contatto nuovo per la restituzione).
+    bool Accumulate(size_t pairIndex, const CollisionInfo &info, float correction);
+
+    // Voce della coppia, nullptr se la coppia non era in contatto
+    const CachedContact *GetContact(size_t pairIndex) const { return slots[pairIndex]; }
+
+    // true se la coppia e stata in contatto nello step corrente
+    bool IsTouched(size_t pairIndex) const { return slots[pairIndex] && slots[pairIndex]->lastTouched == stamp; }
+
+    // true se la coppia era in contatto anche nello step precedente (dopo Accumulate)
+    bool IsResting(size_t pairIndex) const { return slots[pairIndex] && slots[pairIndex]->age > 1; }
+
+    // Fine step: inserisce i contatti nuovi, elimina quelli non piu toccati
+    void EndStep();
+
+    void RemoveBody(const RigidBody *body);
+    void Clear();
+    size_t GetContactCount() const { return contacts.size(); }
+};
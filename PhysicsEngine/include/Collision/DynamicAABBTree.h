@@ -0,0 +1,87 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+// BVH dinamica: le foglie hanno AABB "grasse" e un corpo viene reinserito
+// solo quando esce dalla sua. Bilanciata con rotazioni AVL, mantiene la
+// lista delle coppie in modo incrementale (nuove / rimosse a ogni Update).
+class DynamicAABBTree : public Broadphase {
+private:
+    static const int nullNode = -1;
+
+    struct Bounds {
+        float minX, minY, maxX, maxY;
+    };
+
+    struct Node {
+        Bounds fat;
+        RigidBody *body;            // Solo foglie
+        int parent;                 // Nella free list: prossimo nodo libero
+        int child1;
+        int child2;
+        int height;                 // 0 = foglia, -1 = libero
+        bool moved;                 // Reinserito in questo Update
+        bool dying;                 // Corpo rimosso dal mondo
+        unsigned int stamp;
+
+        bool IsLeaf() const { return child1 == nullNode; }
+    };
+
+    struct ProxyPair {
+        int proxyA;
+        int proxyB;
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    std::unordered_map<RigidBody *, int> proxyOf;
+
+    std::vector<ProxyPair> overlapPairs;
+    std::unordered_set<uint64_t> pairKeys;
+    std::vector<BroadphasePair> newPairs;
+    std::vector<BroadphasePair> removedPairs;
+
+    std::vector<int> moveBuffer;
+    std::vector<int> dyingProxies;
+    std::vector<int> stack;         // Stack di attraversamento riusato
+
+    float displacementMultiplier;   // Allunga l'AABB grassa nella direzione del moto
+    bool trackPairs;                // false: solo inserimenti e query, nessuna lista coppie
+    unsigned int updateStamp;
+    int reinsertCount;
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    Bounds MakeFatBounds(const RigidBody *body) const;
+    void UpdatePairs();
+    BroadphasePair MakePair(int proxyA, int proxyB) const;
+
+    static Bounds Union(const Bounds &a, const Bounds &b);
+    static float Perimeter(const Bounds &b);
+    static bool Contains(const Bounds &outer, const Bounds &inner);
+    static bool Overlaps(const Bounds &a, const Bounds &b);
+    static uint64_t PairKey(int proxyA, int proxyB);
+
+public:
+    // trackPairs = false per una struttura di sole query (es. i corpi statici,
+    // le cui coppie tra loro non servono): FindPairs resta vuoto
+    DynamicAABBTree(float margin = 0.1f, float displacementMultiplier = 4.0f, bool trackPairs = true);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    // Variazioni della lista coppie nell'ultimo Update. Le coppie rimosse
+    // possono riferirsi a corpi gia distrutti: confrontarle, non dereferenziarle.
+    const std::vector<BroadphasePair> &GetNewPairs() const { return newPairs; }
+    const std::vector<BroadphasePair> &GetRemovedPairs() const { return removedPairs; }
+    int GetReinsertCount() const { return reinsertCount; }
+    int GetHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+};
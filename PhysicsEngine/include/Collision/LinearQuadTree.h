@@ -0,0 +1,50 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <cstdint>
+
+// QuadTree lineare: i corpi sono ordinati per codice di Morton del centro,
+// quindi ogni nodo copre un intervallo contiguo dell'array ordinato. Tutti i
+// nodi vivono in un unico array che viene riusato a ogni build (nessuna free).
+class LinearQuadTree : public Broadphase {
+private:
+    struct Item {
+        uint32_t code;              // Codice di Morton (16 bit per asse)
+        uint32_t body;              // Indice in boxes
+    };
+
+    struct Box {
+        RigidBody *body;
+        float minX, minY, maxX, maxY;
+    };
+
+    struct Node {
+        float minX, minY, maxX, maxY;   // Unione delle AABB dei corpi del nodo
+        uint32_t begin, end;            // Intervallo in sorted
+        int32_t firstChild;             // -1 per le foglie, figli contigui
+        uint32_t childCount;
+        uint32_t level;
+    };
+
+    std::vector<Box> boxes;         // Nell'ordine di Update
+    std::vector<Box> sorted;        // Nell'ordine di Morton
+    std::vector<Item> items;
+    std::vector<Item> scratch;      // Ping-pong del radix sort
+    std::vector<Node> nodes;        // Arena dei nodi
+    uint32_t leafCapacity;
+
+    static const uint32_t maxLevel = 16;
+
+    static uint32_t SpreadBits(uint32_t v);
+    void RadixSort();
+    void BuildNodes();
+
+public:
+    LinearQuadTree(uint32_t leafCapacity = 8, float margin = 0.1f);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    size_t GetNodeCount() const { return nodes.size(); }
+};
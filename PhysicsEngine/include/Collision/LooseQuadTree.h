@@ -0,0 +1,65 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// QuadTree "loose": ogni nodo accetta corpi grandi fino a meta della sua cella
+// purche il centro ci cada dentro, e li contiene nei suoi bounds allargati (2x).
+// Ogni corpo vive quindi in un solo nodo, senza duplicati. La radice cresce
+// e si ricentra da sola seguendo i corpi: nessun bound fisso del mondo.
+class LooseQuadTree : public Broadphase {
+private:
+    static const int32_t nullIndex = -1;
+    static const int maxDepth = 20;
+
+    struct Node {
+        float centerX, centerY;
+        float half;                 // Semi-lato della cella "stretta"
+        int32_t children[4];
+        int32_t parent;             // Nella free list: prossimo nodo libero
+        int32_t firstProxy;         // Lista intrusiva dei corpi del nodo
+    };
+
+    struct Proxy {
+        RigidBody *body;
+        float minX, minY, maxX, maxY;
+        int32_t node;
+        int32_t prev, next;
+        unsigned int stamp;
+    };
+
+    std::vector<Node> nodes;
+    int32_t freeNodes;
+    int32_t root;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> freeProxies;
+    std::unordered_map<RigidBody *, uint32_t> proxyOf;
+    unsigned int updateStamp;
+    int relocationCount;
+
+    int32_t AllocateNode(float centerX, float centerY, float half, int32_t parent);
+    void FreeNode(int32_t node);
+    bool Fits(const Node &node, const Proxy &proxy) const;
+    void GrowToFit(const Proxy &proxy);
+    void ShrinkRoot();
+    void InsertProxy(uint32_t proxy);
+    void RemoveProxy(uint32_t proxy);
+    void PruneEmpty(int32_t node);
+
+    bool LooseOverlap(const Node &a, const Node &b) const;
+    void PairsWithin(int32_t node, std::vector<BroadphasePair> &pairs) const;
+    void PairsBetween(int32_t a, int32_t b, std::vector<BroadphasePair> &pairs) const;
+    void ProxyVsSubtree(const Proxy &proxy, int32_t node, std::vector<BroadphasePair> &pairs) const;
+    void QuerySubtree(int32_t node, float minX, float minY, float maxX, float maxY, std::vector<RigidBody *> &found) const;
+
+public:
+    LooseQuadTree(float margin = 0.1f);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    int GetRelocationCount() const { return relocationCount; }
+    float GetRootHalfSize() const { return root == nullIndex ? 0.0f : nodes[root].half; }
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "Collision/CollisionDetection.h"
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <algorithm>
+
+// Test di contatto per una coppia di forme, scelto a compile time.
+// Le coppie arrivano sempre con A <= B nell'ordine di ShapeType: una nuova
+// forma richiede solo le sue specializzazioni (e ShapeTypeCount aggiornato).
+template <ShapeType A, ShapeType B>
+struct ContactKernel;  // Non definito: una coppia senza kernel non compila
+
+template <>
+struct ContactKernel<ShapeType::CIRCLE, ShapeType::CIRCLE> {
+    static bool Detect(RigidBody *a, RigidBody *b, CollisionInfo &info) { return CollisionDetection::CircleVsCircle(a, b, info); }
+};
+
+template <>
+struct ContactKernel<ShapeType::CIRCLE, ShapeType::AABB> {
+    static bool Detect(RigidBody *circle, RigidBody *box, CollisionInfo &info) { return CollisionDetection::CircleVsAABB(circle, box, info); }
+};
+
+template <>
+struct ContactKernel<ShapeType::AABB, ShapeType::AABB> {
+    static bool Detect(RigidBody *a, RigidBody *b, CollisionInfo &info) { return CollisionDetection::AABBvsAABB(a, b, info); }
+};
+
+// Coppie candidate divise per tipo di coppia, un bucket per ogni (A, B) con A <= B.
+// Ogni bucket gira in un ciclo stretto col suo kernel: nessun branch sulla forma.
+class PairBuckets {
+private:
+    static const int bucketCount = ShapeTypeCount * ShapeTypeCount;
+    std::vector<BroadphasePair> buckets[bucketCount];
+
+    static int Index(ShapeType a, ShapeType b) { return static_cast<int>(a) * ShapeTypeCount + static_cast<int>(b); }
+
+    template <ShapeType A, ShapeType B, typename Solver>
+    static void RunBucket(const std::vector<BroadphasePair> &bucket, size_t firstIndex, const unsigned int *begin, const unsigned int *end, Solver &solver);
+
+    template <int I, typename Solver>
+    void Dispatch(size_t firstIndex, const unsigned int *begin, const unsigned int *end, Solver &solver) const;
+
+public:
+    // Svuota i bucket e ci distribuisce pairs, scambiando A e B dove serve
+    void Build(const std::vector<BroadphasePair> &pairs);
+    void Clear();
+
+    std::vector<BroadphasePair> &Get(ShapeType a, ShapeType b) { return buckets[Index(a, b)]; }
+    size_t Size() const;
+
+    // visitor(pair, pairIndex) per ogni coppia, nello stesso ordine di ForEachContact.
+    // pairIndex va da 0 a Size() - 1 e identifica la coppia per tutto lo step.
+    template <typename Visitor>
+    void ForEachPair(Visitor &&visitor) const;
+
+    // solver(const CollisionInfo &, pairIndex) per ogni coppia in contatto tra
+    // i pairIndex di [begin, end), crescenti (le coppie di un'isola, di un
+    // colore): il tratto che cade in ogni bucket gira col suo kernel
+    template <typename Solver>
+    void ForEachContact(const unsigned int *begin, const unsigned int *end, Solver &&solver) const { Dispatch<0>(0, begin, end, solver); }
+
+    // Kernel scelto a runtime da una tabella, per chi visita le coppie fuori
+    // dall'ordine dei bucket. Vuole A <= B come nei bucket.
+    static bool Detect(const BroadphasePair &pair, CollisionInfo &info);
+};
+
+template <typename Visitor>
+void PairBuckets::ForEachPair(Visitor &&visitor) const
+{
+    size_t index = 0;
+    for (const auto &bucket : buckets) {
+        for (const auto &pair : bucket)
+            visitor(pair, index++);
+    }
+}
+
+template <ShapeType A, ShapeType B, typename Solver>
+void PairBuckets::RunBucket(const std::vector<BroadphasePair> &bucket, size_t firstIndex, const unsigned int *begin, const unsigned int *end, Solver &solver)
+{
+    for (const unsigned int *index = begin; index != end; index++) {
+        const BroadphasePair &pair = bucket[*index - firstIndex];
+        CollisionInfo info;
+        if (ContactKernel<A, B>::Detect(pair.bodyA, pair.bodyB, info))
+            solver(info, *index);
+    }
+}
+
+template <int I, typename Solver>
+void PairBuckets::Dispatch(size_t firstIndex, const unsigned int *begin, const unsigned int *end, Solver &solver) const
+{
+    if constexpr (I < bucketCount) {
+        if (begin == end)
+            return;
+        constexpr ShapeType A = static_cast<ShapeType>(I / ShapeTypeCount);
+        constexpr ShapeType B = static_cast<ShapeType>(I % ShapeTypeCount);
+        size_t lastIndex = firstIndex + buckets[I].size();
+        const unsigned int *split = std::lower_bound(begin, end, static_cast<unsigned int>(lastIndex));
+        if constexpr (A <= B)
+            RunBucket<A, B>(buckets[I], firstIndex, begin, split, solver);
+        Dispatch<I + 1>(lastIndex, split, end, solver);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include "Collision/Quadtree.h"
+#include <vector>
+
+// Adatta il QuadTree all'interfaccia Broadphase: una query per corpo,
+// una sola volta per step, con le coppie raccolte in una lista piatta.
+// I corpi col centro fuori dai bounds del QuadTree non entrano nell'albero:
+// coppie e query li controllano con una scansione lineare.
+class QuadTreeBroadphase : public Broadphase {
+private:
+    QuadTree tree;
+    AABB worldBounds;                   // Bounds della radice
+    bool persistent;                    // Update incrementale invece di Clear + Insert
+    std::vector<RigidBody *> inserted;  // Corpi dell'ultimo Update
+    std::vector<RigidBody *> outside;   // Quelli col centro fuori da worldBounds
+    float maxHalfExtent;                // Semi-dimensione massima tra i corpi
+
+public:
+    QuadTreeBroadphase(const AABB &worldBounds, int capacity, float margin = 0.1f);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    void SetPersistent(bool enabled);
+    int GetRelocationCount() const { return persistent ? tree.GetRelocationCount() : 0; }
+};
@@ -2,14 +2,16 @@
 #include "Collision/AABB.h"
 #include "Physics/RigidBody.h"
 #include <vector>
-#include <set>
 #include <memory>
+#include <unordered_map>
 
 class QuadTree {
 private:
     AABB boundary;
     int capacity;
     std::vector<RigidBody *> objects;
+    QuadTree *parent;               // nullptr per la radice
+    QuadTree *root;
 
     bool divided;
     std::unique_ptr<QuadTree> northWest;
@@ -17,13 +19,57 @@ private:
     std::unique_ptr<QuadTree> southWest;
     std::unique_ptr<QuadTree> southEast;
 
+    // Stato della modalita persistente (usato solo dalla radice)
+    bool persistent;
+    struct LeafEntry {
+        QuadTree *leaf;             // Foglia che contiene il corpo
+        unsigned int stamp;         // Ultimo Update in cui il corpo era nel mondo
+    };
+    std::unordered_map<RigidBody *, LeafEntry> leafOf;
+    unsigned int updateStamp;
+    int relocationCount;            // Corpi spostati di foglia nell'ultimo Update
+
     void Subdivide();
     bool InsertIntoChildren(RigidBody *body);
+    void RemoveObject(RigidBody *body);
+    void TryMerge();
 
 public:
-    QuadTree(const AABB &boundary, int capacity);
+    QuadTree(const AABB &boundary, int capacity, QuadTree *parent = nullptr);
 
     bool Insert(RigidBody *body);
-    void Query(const AABB &range, std::set<RigidBody *> &found);
     void Clear();
+
+    // Chiama visitor(RigidBody *) per ogni corpo con il centro in range.
+    // Template: il visitor viene inlineato e non si alloca nulla.
+    template <typename Visitor>
+    void Visit(const AABB &range, Visitor &&visitor) const;
+
+    // Aggiunge in coda a found i corpi con il centro in range, senza svuotarlo:
+    // il buffer e del chiamante e, riusato tra le query, non rialloca.
+    // Ogni corpo e salvato in un solo nodo, quindi non serve uno stamp anti-duplicati.
+    void Query(const AABB &range, std::vector<RigidBody *> &found) const;
+
+    // Aggiornamento incrementale: sposta solo i corpi usciti dalla loro foglia
+    void Update(const std::vector<RigidBody *> &bodies);
+    int GetRelocationCount() const { return relocationCount; }
 };
+
+template <typename Visitor>
+void QuadTree::Visit(const AABB &range, Visitor &&visitor) const
+{
+    if (!boundary.Intersects(range))
+        return;
+
+    for (auto *obj : objects) {
+        if (range.Contains(obj->position))
+            visitor(obj);
+    }
+
+    if (divided) {
+        northWest->Visit(range, visitor);
+        northEast->Visit(range, visitor);
+        southWest->Visit(range, visitor);
+        southEast->Visit(range, visitor);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <cstdint>
+
+// Griglia uniforme con hashing delle celle: nessun bound fisso del mondo.
+// Le celle vivono in array piatti (counting sort per bucket) e vengono
+// "svuotate" incrementando la generazione, senza deallocare nulla.
+class SpatialHashGrid : public Broadphase {
+private:
+    struct Item {
+        RigidBody *body;
+        float minX, minY, maxX, maxY;
+        bool oversized;
+    };
+
+    struct Entry {
+        uint32_t item;
+        uint32_t bucket;
+        int32_t cellX, cellY;
+    };
+
+    std::vector<Item> items;
+    std::vector<uint32_t> oversized;        // Corpi troppo grandi per la griglia (es. pavimenti)
+    std::vector<Entry> unsortedEntries;
+    std::vector<Entry> entries;             // Ordinate per bucket
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> bucketCount;
+    std::vector<unsigned int> bucketGeneration;
+    std::vector<uint32_t> usedBuckets;
+    std::vector<float> extents;             // Scratch per la mediana delle dimensioni
+    unsigned int generation;
+    uint32_t bucketMask;
+
+    float fixedCellSize;                    // 0 = derivata dalle dimensioni dei corpi
+    float cellSize;
+    float invCellSize;
+
+    static const int maxCellsPerBody = 64;
+
+    void ComputeCellSize();
+    void EnsureBuckets(size_t entryCount);
+    int32_t CellCoord(float value) const;
+    uint32_t HashCell(int32_t cellX, int32_t cellY) const;
+
+public:
+    SpatialHashGrid(float cellSize = 0.0f, float margin = 0.1f);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    float GetCellSize() const { return cellSize; }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "Collision/Broadphase.h"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Sweep and prune sull'asse X: gli estremi restano ordinati tra un frame e
+// l'altro, quindi l'insertion sort su dati quasi ordinati costa circa O(n)
+class SweepAndPrune : public Broadphase {
+private:
+    struct Endpoint {
+        float value;
+        uint32_t proxy;
+        bool isMin;
+    };
+
+    struct Proxy {
+        RigidBody *body;           // nullptr se il proxy e libero
+        float minX, maxX;
+        float minY, maxY;
+        uint32_t activeIndex;      // Posizione nella lista attiva durante lo sweep
+        unsigned int stamp;        // Ultimo Update in cui il corpo era nel mondo
+    };
+
+    std::vector<Endpoint> endpoints;
+    std::vector<Proxy> proxies;
+    std::vector<uint32_t> freeProxies;
+    std::unordered_map<RigidBody *, uint32_t> proxyOf;
+    std::vector<uint32_t> active;
+    unsigned int updateStamp;
+    int swapCount;                 // Scambi dell'insertion sort nell'ultimo Update
+    float maxWidth;                // Larghezza massima su X, limita la ricerca in Query
+
+    static bool EndpointLess(const Endpoint &a, const Endpoint &b);
+    void RemoveStaleProxies();
+    void SortEndpoints(bool fullSort);
+
+public:
+    SweepAndPrune(float margin = 0.1f);
+
+    void Update(const std::vector<RigidBody *> &bodies) override;
+    void FindPairs(std::vector<BroadphasePair> &pairs) override;
+    void Query(const AABB &range, std::vector<RigidBody *> &found) override;
+
+    int GetSwapCount() const { return swapCount; }
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "Constraints/DistanceConstraints.h"
+#include "Constraints/PinConstraint.h"
+#include "Physics/IslandBuilder.h"
+#include <vector>
+#include <cstddef>
+
+// Catene di vincoli (corde, pendoli): percorsi di distanze, eventualmente
+// agganciati a un pin, i cui corpi interni hanno esattamente due vincoli.
+// Invece di una correzione per vincolo, una catena si proietta tutta
+// insieme sul punto piu vicino (in massa) che soddisfa i vincoli, con passi
+// di Newton sul sistema KKT: ordinato per anello (lambda_(j-1), x_j) e
+// tridiagonale a blocchi 3x3, si risolve con l'algoritmo di Thomas in O(n).
+// La rigidezza geometrica (tensione / lunghezza) nel sistema tiene stabili
+// anche le catene molto tese, dove J W J^T lambda = -C da solo diverge.
+// Gli estremi possono essere condivisi con altre catene o altri vincoli
+// (Gauss-Seidel a blocchi).
+class ChainSolver {
+private:
+    struct Chain {
+        size_t linkBegin, linkEnd;             // In links, links + 1 posizioni da slotBegin
+        size_t slotBegin;
+    };
+
+    // Per anello: vincolo nel mondo (distanze, poi pin) e dati copiati alla Build
+    std::vector<unsigned int> links;
+    std::vector<float> linkRestLength;
+    std::vector<float> linkCompliance;
+    std::vector<float *> linkLambda;           // Moltiplicatore XPBD del vincolo
+
+    // Per posizione lungo la catena: corpo o punto del pin, 0 se fisso
+    std::vector<Vector2 *> slotPosition;
+    std::vector<float> slotInverseMass;
+
+    // Scratch della Solve, negli intervalli della catena (isole in parallelo)
+    struct LinkScratch {
+        double directionX, directionY;
+        double length;
+        double error;                          // C + alpha * lambda, col lambda attuale
+        double lambda;                         // Di questa proiezione
+    };
+    struct BlockScratch {                      // Incognite (lambda_(j-1), x_j, y_j)
+        double inverse[9];                     // Inverso del blocco diagonale eliminato
+        double upper[6];                       // Righe x_j, y_j verso (lambda_j, x_(j+1), y_(j+1))
+        double rhs[3];
+        double referenceX, referenceY;         // Posizione da proiettare
+    };
+    std::vector<LinkScratch> linkScratch;
+    std::vector<BlockScratch> blockScratch;
+    static constexpr int maxNewtonIterations = 16;
+
+    std::vector<Chain> chains;
+    std::vector<unsigned int> islandChains;    // Catene per isola: da chainOffsets[i] a chainOffsets[i + 1]
+    std::vector<size_t> chainOffsets;
+    std::vector<unsigned int> looseConstraints;  // Per isola: vincoli fuori dalle catene, ordinati
+    std::vector<size_t> looseOffsets;
+
+    // Scratch della Build
+    enum LinkState : unsigned char { linkExcluded, linkFree, linkVisited, linkChained };
+    std::vector<unsigned char> linkState;      // Per vincolo
+    std::vector<int> nodeDegree;               // Per solverIndex: vincoli ammessi
+    std::vector<unsigned int> nodeLinks;       // Per solverIndex: i primi due
+    std::vector<int> constraintIsland;
+    std::vector<unsigned int> chainIsland;
+
+    void PushSlot(Vector2 *position, const RigidBody *body);
+    float SolveChain(const Chain &chain, float inverseDt2);
+
+public:
+    // Trova le catene tra i vincoli delle isole di islands. In PBD solo i
+    // vincoli con stiffness 1 ne fanno parte, in XPBD tutti (compliance
+    // nel sistema). nodeCount = corpi con solverIndex valido.
+    void Build(DistanceConstraint *distances, size_t distanceCount, PinConstraint *pins, size_t pinCount,
+        const IslandBuilder &islands, size_t nodeCount, bool xpbd);
+
+    // Vincoli dell'isola da risolvere uno per uno: quelli di
+    // IslandBuilder::GetConstraints() meno gli anelli delle catene
+    void GetLooseConstraints(size_t island, const unsigned int *&begin, const unsigned int *&end) const;
+
+    // Una soluzione diretta di ogni catena dell'isola. inverseDt2 = 1 / h^2
+    // del sottopasso XPBD, 0 in PBD. Ritorna l'errore di lunghezza massimo
+    // prima delle correzioni.
+    float Solve(size_t island, float inverseDt2);
+
+    size_t GetChainCount() const { return chains.size(); }
+    size_t GetLinkCount() const { return links.size(); }
+};
@@ -1,21 +1,18 @@
 #pragma once
-#include "Math/Vector2.h"
 
-class RigidBody;  // Forward declaration
+// Tipi di vincolo: uno storage contiguo per tipo in PhysicsWorld
+enum class ConstraintType {
+    DISTANCE,
+    PIN
+};
 
-class Constraint {
-protected:
-    RigidBody *particleA;
-    float stiffness;
+// Riferimento leggero a un vincolo del mondo. Resta valido finche il vincolo
+// esiste: dopo la rimozione la generazione non corrisponde piu e il lookup
+// restituisce nullptr, anche se l'id viene riusato.
+struct ConstraintHandle {
+    static constexpr unsigned int nullId = ~0u;  // Vincolo mai creato (corpi mancanti)
 
-    Constraint(RigidBody* a, float stiff = 1.0f);
-public:
-    virtual ~Constraint();
-
-    // Metodi virtuali puri - ogni vincolo li implementa
-    virtual void Solve() = 0;
-    virtual bool IsValid() const = 0;
-    virtual RigidBody *GetParticleA() const = 0;
-    virtual RigidBody *GetParticleB() const = 0;  // Ritorner nullptr per Pin
-    virtual Vector2 GetPin() const = 0;           // Ritorner ZERO se non  un Pin
-};
\ No newline at end of file
+    ConstraintType type;
+    unsigned int id;
+    unsigned int generation;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include "Constraints/Constraint.h"
+#include <vector>
+#include <cstddef>
+
+// Vincoli di un solo tipo in un array contiguo, risolti in batch senza
+// chiamate virtuali. Gli handle passano da una tabella id -> posizione,
+// cosi le rimozioni possono compattare l'array senza invalidarli.
+template <typename T, ConstraintType Type>
+class ConstraintArray {
+private:
+    static constexpr unsigned int freePosition = ~0u;
+
+    std::vector<T> items;                   // Nell'ordine di risoluzione
+    std::vector<unsigned int> itemIds;      // Per posizione: id del vincolo
+    std::vector<unsigned int> positions;    // Per id: posizione in items, freePosition se libero
+    std::vector<unsigned int> generations;  // Per id: aumenta a ogni rimozione
+    std::vector<unsigned int> freeIds;
+
+public:
+    ConstraintHandle Add(const T &item)
+    {
+        unsigned int id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else {
+            id = static_cast<unsigned int>(positions.size());
+            positions.push_back(freePosition);
+            generations.push_back(0);
+        }
+
+        positions[id] = static_cast<unsigned int>(items.size());
+        items.push_back(item);
+        itemIds.push_back(id);
+        return { Type, id, generations[id] };
+    }
+
+    T *Get(const ConstraintHandle &handle)
+    {
+        if (handle.type != Type || handle.id >= positions.size() || generations[handle.id] != handle.generation)
+            return nullptr;
+        unsigned int position = positions[handle.id];
+        return position == freePosition ? nullptr : &items[position];
+    }
+
+    bool Remove(const ConstraintHandle &handle)
+    {
+        T *item = Get(handle);
+        if (!item)
+            return false;
+
+        unsigned int position = positions[handle.id];
+        RemoveIf([&](const T &candidate) { return &candidate == &items[position]; });
+        return true;
+    }
+
+    // Rimuove i vincoli che soddisfano pred, mantenendo l'ordine degli altri
+    template <typename Predicate>
+    void RemoveIf(Predicate pred)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < items.size(); i++) {
+            unsigned int id = itemIds[i];
+            if (pred(items[i])) {
+                positions[id] = freePosition;
+                generations[id]++;
+                freeIds.push_back(id);
+                continue;
+            }
+
+            if (kept != i) {
+                items[kept] = items[i];
+                itemIds[kept] = id;
+            }
+            positions[id] = static_cast<unsigned int>(kept);
+            kept++;
+        }
+        items.erase(items.begin() + kept, items.end());
+        itemIds.resize(kept);
+    }
+
+    void Clear()
+    {
+        for (unsigned int id : itemIds) {
+            positions[id] = freePosition;
+            generations[id]++;
+            freeIds.push_back(id);
+        }
+        items.clear();
+        itemIds.clear();
+    }
+
+    size_t Size() const { return items.size(); }
+    T &operator[](size_t i) { return items[i]; }
+    const T &operator[](size_t i) const { return items[i]; }
+    const std::vector<T> &GetItems() const { return items; }
+};
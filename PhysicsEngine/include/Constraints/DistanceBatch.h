@@ -0,0 +1,52 @@
+#pragma once
+#include "Constraints/DistanceConstraints.h"
+#include "Physics/GraphColoring.h"
+#include "Core/CpuFeatures.h"
+#include <vector>
+#include <cstddef>
+
+// Vincoli di distanza riordinati per colore (nessun corpo condiviso dentro un
+// colore) e tenuti in array separati (SoA): il solver ne risolve 4 (SSE2) o 8
+// (AVX) per istruzione, con gather e scatter delle posizioni. L'ordine di
+// risoluzione e quello dei colori, non quello di inserimento: il risultato e
+// vicino ma non identico a DistanceConstraint::SolveBatch.
+class DistanceBatchSolver {
+private:
+    std::vector<RigidBody *> bodyA, bodyB;   // Una corsia per vincolo, colore dopo colore
+    std::vector<float> restLength;
+    std::vector<float> weightA, weightB;     // stiffness * inverseMass / somma, 0 se il corpo e fisso
+    std::vector<size_t> colorEnds;           // Colore c = corsie da colorEnds[c - 1] a colorEnds[c]
+    std::vector<unsigned char> laneFixed;    // Bit 0: A fisso, bit 1: B fisso, alla colorazione
+    std::vector<unsigned int> builtIndices;  // Elenco dell'ultima colorazione
+    std::vector<unsigned int> laneOf;        // Per posizione nell'elenco: corsia, o noLane
+    std::vector<unsigned int> overflow;      // Oltre i colori disponibili: scalari, in ordine
+    static constexpr unsigned int noLane = ~0u;
+    DistanceConstraint *source;
+    GraphColoring coloring;
+    bool fastInverseSqrt;
+
+    void Color(const unsigned int *indices, size_t count, size_t bodyCount);
+    bool Refresh();                          // false se la colorazione non vale piu
+
+public:
+    DistanceBatchSolver();
+
+    // Colora e impacchetta constraints[indices[i]] per i da 0 a count - 1.
+    // bodyCount = numero di solverIndex validi; un corpo con solverIndex -1
+    // conta come fisso. Va chiamato a ogni step: con lo stesso elenco, gli
+    // stessi corpi e gli stessi corpi fissi la colorazione si riusa e si
+    // aggiornano solo lunghezze e pesi.
+    void Build(DistanceConstraint *constraints, const unsigned int *indices, size_t count, size_t bodyCount);
+
+    // Una iterazione su tutti i vincoli impacchettati. Ritorna l'errore di
+    // lunghezza massimo prima delle correzioni (solo vincoli che si muovono).
+    float Solve();
+    float Solve(SimdLevel level);
+
+    // Radice inversa approssimata (rsqrt + un passo di Newton) al posto di sqrt e divisione
+    void SetFastInverseSqrt(bool enabled) { fastInverseSqrt = enabled; }
+    bool GetFastInverseSqrt() const { return fastInverseSqrt; }
+
+    size_t Size() const { return bodyA.size() + overflow.size(); }
+    size_t GetColorCount() const { return colorEnds.size(); }
+};
@@ -1,19 +1,128 @@
 #pragma once
-#include <memory>
-#include "Constraints/Constraint.h"
 #include "Physics/RigidBody.h"
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
 
-class DistanceConstraint : public Constraint{
-private:
+// Distanza fissa tra due corpi. Dati semplici, niente virtuali: il mondo li
+// tiene in un array contiguo e li risolve con SolveBatch.
+struct DistanceConstraint {
+	RigidBody *particleA;
 	RigidBody *particleB;
 	float restLength;
+	float stiffness;       // PBD: frazione dell'errore corretta a ogni iterazione (0-1)
+	float compliance;      // XPBD: inverso della rigidezza in m/N, 0 = rigido
+	float lambda;          // XPBD: moltiplicatore accumulato nel sottopasso
 
-public:
 	DistanceConstraint(RigidBody *a, RigidBody *b, float stiff = 1.0f);
-	
-	bool IsValid() const override { return particleA && particleB; }
-	RigidBody *GetParticleA() const override { return particleA; }
-	RigidBody *GetParticleB() const override { return particleB; }
-	Vector2 GetPin() const override { return Vector2::ZERO; }
-	void Solve() override;
-};
\ No newline at end of file
+
+	RigidBody *GetParticleA() const { return particleA; }
+	RigidBody *GetParticleB() const { return particleB; }
+
+	// Ritorna l'errore di lunghezza prima della correzione, 0 se nessun estremo si muove
+	inline float Solve();
+
+	// Correzioni calcolate senza scriverle (solver Jacobi): A += deltaA, B += deltaB.
+	// false se non c'e niente da correggere; residual come il ritorno di Solve.
+	inline bool ComputeCorrection(Vector2 &deltaA, Vector2 &deltaB, float &residual) const;
+
+	// Risolve constraints[indices[i] - firstIndex] per i da 0 a count - 1, in
+	// ordine. Ritorna l'errore massimo trovato.
+	static float SolveBatch(DistanceConstraint *constraints, const unsigned int *indices, size_t count, unsigned int firstIndex = 0)
+	{
+		float maxError = 0.0f;
+		for (size_t i = 0; i < count; i++)
+			maxError = std::max(maxError, constraints[indices[i] - firstIndex].Solve());
+		return maxError;
+	}
+
+	// XPBD: correzione con compliance / dt^2 del sottopasso, stiffness ignorata.
+	// Ritorna l'errore prima della correzione come Solve.
+	inline float SolveXpbd(float inverseDt2);
+	inline bool ComputeXpbdCorrection(float inverseDt2, Vector2 &deltaA, Vector2 &deltaB, float &residual);
+
+	static float SolveXpbdBatch(DistanceConstraint *constraints, const unsigned int *indices, size_t count, float inverseDt2)
+	{
+		float maxError = 0.0f;
+		for (size_t i = 0; i < count; i++)
+			maxError = std::max(maxError, constraints[indices[i]].SolveXpbd(inverseDt2));
+		return maxError;
+	}
+};
+
+inline bool DistanceConstraint::ComputeCorrection(Vector2 &deltaA, Vector2 &deltaB, float &residual) const
+{
+	Vector2 delta = particleB->position - particleA->position;
+	float currentLength = delta.Length();
+	float error = currentLength - restLength;
+	residual = std::abs(error);
+
+	if (residual < 1e-6f) return false;
+
+	Vector2 direction = delta / currentLength;
+
+	float invMassTotal = particleA->inverseMass + particleB->inverseMass;
+
+	if (invMassTotal < 1e-6f) {
+		residual = 0.0f;
+		return false;
+	}
+
+	error *= stiffness;
+
+	deltaA = direction * error * (particleA->inverseMass / invMassTotal);
+	deltaB = direction * -error * (particleB->inverseMass / invMassTotal);
+	return true;
+}
+
+inline float DistanceConstraint::Solve()
+{
+	Vector2 deltaA, deltaB;
+	float residual;
+	if (!ComputeCorrection(deltaA, deltaB, residual))
+		return residual;
+
+	// Un estremo fisso non si scrive: col solver a colori e condiviso tra thread
+	if (particleA->inverseMass > 0.0f)
+		particleA->position += deltaA;
+	if (particleB->inverseMass > 0.0f)
+		particleB->position += deltaB;
+	return residual;
+}
+
+inline bool DistanceConstraint::ComputeXpbdCorrection(float inverseDt2, Vector2 &deltaA, Vector2 &deltaB, float &residual)
+{
+	Vector2 delta = particleB->position - particleA->position;
+	float currentLength = delta.Length();
+	float error = currentLength - restLength;
+	residual = 0.0f;
+
+	float invMassTotal = particleA->inverseMass + particleB->inverseMass;
+	float alpha = compliance * inverseDt2;
+
+	if (currentLength < 1e-6f || invMassTotal + alpha < 1e-6f) return false;
+
+	// Delta lambda = (-C - alpha * lambda) / (w + alpha)
+	float deltaLambda = (-error - alpha * lambda) / (invMassTotal + alpha);
+	lambda += deltaLambda;
+
+	Vector2 direction = delta / currentLength;
+	deltaA = direction * -(deltaLambda * particleA->inverseMass);
+	deltaB = direction * (deltaLambda * particleB->inverseMass);
+	residual = std::abs(error);
+	return true;
+}
+
+inline float DistanceConstraint::SolveXpbd(float inverseDt2)
+{
+	Vector2 deltaA, deltaB;
+	float residual;
+	if (!ComputeXpbdCorrection(inverseDt2, deltaA, deltaB, residual))
+		return residual;
+
+	if (particleA->inverseMass > 0.0f)
+		particleA->position += deltaA;
+	if (particleB->inverseMass > 0.0f)
+		particleB->position += deltaB;
+	return residual;
+}
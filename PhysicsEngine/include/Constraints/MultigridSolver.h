@@ -0,0 +1,75 @@
+#pragma once
+#include "Constraints/DistanceConstraints.h"
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+// Gerarchia di livelli sopra una rete di vincoli di distanza (stoffe,
+// griglie): una correzione di Gauss-Seidel si sposta di un vincolo per
+// iterazione, sui livelli grossolani attraversa la griglia in poche.
+// Livello k + 1 = insieme indipendente massimale dei nodi del livello k,
+// collegati quando distano uno o due vincoli; il vincolo grossolano e
+// unilatero (corregge solo l'allungamento) con lunghezza = cammino di riposo
+// piu corto, quindi non blocca nessuna forma ammessa dai vincoli fini.
+// Solve fa la parte grossolana di un V-ciclo: restrizione per iniezione (i
+// nodi grossolani sono corpi), una passata per livello in discesa e in
+// risalita, prolungamento delle correzioni ai nodi del livello sotto come
+// media pesata dei vicini grossolani. La passata sui vincoli fini la fa il
+// mondo subito dopo.
+class MultigridSolver {
+private:
+    struct Edge {
+        unsigned int a, b;                     // Nodi locali
+        float restLength;
+        float stiffness;
+    };
+
+    struct Level {
+        std::vector<unsigned int> nodes;       // Nodi locali del livello
+        std::vector<Edge> edges;               // Vincoli unilateri tra i nodi
+        std::vector<Vector2> entryPositions;   // Per nodo: posizione all'ingresso del V-ciclo
+        // Prolungamento: nodi del livello sotto che non sono in questo,
+        // genitori di fineNodes[i] da parentOffsets[i] a parentOffsets[i + 1]
+        std::vector<unsigned int> fineNodes;
+        std::vector<unsigned int> parentOffsets;
+        std::vector<unsigned int> parents;     // Posizione in nodes
+        std::vector<float> parentWeights;
+    };
+
+    std::vector<RigidBody *> nodeBodies;       // Per nodo locale, nell'ordine di comparsa
+    std::vector<Level> levels;                 // Dal primo livello grossolano in su
+    std::vector<unsigned int> builtIndices;    // Elenco dell'ultima Build
+    std::vector<RigidBody *> builtBodies;      // Estremi dei vincoli dell'ultima Build, a coppie
+    std::vector<float> builtRestLengths;
+    static constexpr size_t minLevelNodes = 16;  // Sotto non si crea un altro livello
+    static constexpr int freeNode = -1;
+    static constexpr int coveredNode = -2;     // Vicino di un nodo gia scelto
+
+    // Scratch della Build
+    std::vector<unsigned int> adjacencyOffsets;
+    std::vector<unsigned int> adjacency;       // Vicini del nodo da adjacencyOffsets[nodo]
+    std::vector<unsigned int> adjacencyEdges;  // Per vicino: vincolo del livello che li collega
+    std::unordered_map<const RigidBody *, unsigned int> nodeOf;
+    std::vector<int> coarseIndex;              // Per nodo locale: posizione nel livello nuovo, o free / covered
+    std::vector<float> bestRest;               // Per nodo locale: cammino piu corto dal nodo in esame
+    std::vector<float> bestStiffness;
+    std::vector<unsigned int> touched;
+
+    void BuildLevel(const std::vector<unsigned int> &nodes, const std::vector<Edge> &edges, Level &coarse);
+    float InverseMass(unsigned int node) const;
+    void Relax(const Level &level);
+    void VCycle(size_t level);
+
+public:
+    // Costruisce la gerarchia sopra constraints[indices[i]] per i da 0 a
+    // count - 1. Va chiamato a ogni step: con lo stesso elenco e gli stessi
+    // corpi la gerarchia si riusa.
+    void Build(DistanceConstraint *constraints, const unsigned int *indices, size_t count);
+
+    // Correzione grossolana di una iterazione, da chiamare prima della
+    // passata normale sui vincoli fini. Un corpo senza solverIndex e fisso.
+    void Solve();
+
+    size_t GetLevelCount() const { return levels.size(); }
+    size_t GetLevelNodeCount(size_t level) const { return levels[level].nodes.size(); }
+};
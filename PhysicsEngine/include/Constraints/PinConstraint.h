@@ -1,19 +1,112 @@
 #pragma once
-#include "Constraints/Constraint.h"
 #include "Physics/RigidBody.h"
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
 
-class PinConstraint : public Constraint {
-private:
+// Corpo tenuto a distanza fissa da un punto del mondo
+struct PinConstraint {
+    RigidBody *particleA;
     Vector2 pin;           // Punto fisso nello spazio
     float restLength;      // Distanza fissa dal pin al corpo
+    float stiffness;       // PBD: frazione dell'errore corretta a ogni iterazione (0-1)
+    float compliance;      // XPBD: inverso della rigidezza in m/N, 0 = rigido
+    float lambda;          // XPBD: moltiplicatore accumulato nel sottopasso
 
-public:
     PinConstraint(RigidBody *b, Vector2 p, float stif);
 
-    // TODO: Implementa i metodi virtuali
-    void Solve() override;
-    bool IsValid() const override { return (particleA!=nullptr); }
-    RigidBody *GetParticleA() const override { return particleA; }
-    RigidBody *GetParticleB() const override { return nullptr; }
-    Vector2 GetPin() const override { return pin; }
-};
\ No newline at end of file
+    RigidBody *GetParticleA() const { return particleA; }
+    Vector2 GetPin() const { return pin; }
+
+    // Ritorna l'errore di distanza dal pin prima della correzione, 0 se il corpo e fisso
+    inline float Solve();
+
+    // Correzione calcolata senza scriverla (solver Jacobi), come DistanceConstraint
+    inline bool ComputeCorrection(Vector2 &deltaA, float &residual) const;
+
+    // Risolve constraints[indices[i] - firstIndex] per i da 0 a count - 1, in
+    // ordine. Ritorna l'errore massimo trovato.
+    static float SolveBatch(PinConstraint *constraints, const unsigned int *indices, size_t count, unsigned int firstIndex = 0)
+    {
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; i++)
+            maxError = std::max(maxError, constraints[indices[i] - firstIndex].Solve());
+        return maxError;
+    }
+
+    // XPBD: come DistanceConstraint::SolveXpbd con il pin di massa infinita
+    inline float SolveXpbd(float inverseDt2);
+    inline bool ComputeXpbdCorrection(float inverseDt2, Vector2 &deltaA, float &residual);
+
+    static float SolveXpbdBatch(PinConstraint *constraints, const unsigned int *indices, size_t count, unsigned int firstIndex, float inverseDt2)
+    {
+        float maxError = 0.0f;
+        for (size_t i = 0; i < count; i++)
+            maxError = std::max(maxError, constraints[indices[i] - firstIndex].SolveXpbd(inverseDt2));
+        return maxError;
+    }
+};
+
+inline bool PinConstraint::ComputeCorrection(Vector2 &deltaA, float &residual) const
+{
+    residual = 0.0f;
+    if (particleA->inverseMass <= 0.0f) return false;  // Fisso: niente scritture (solver a colori)
+
+    Vector2 delta = pin - particleA->position;
+    float currentLength = delta.Length();
+    float error = currentLength - restLength;
+    residual = std::abs(error);
+
+    if (residual < 1e-6f) return false;
+
+    // Corpo sul pin: direzione indefinita, non correggibile
+    if (std::abs(currentLength) < 1e-6f) {
+        residual = 0.0f;
+        return false;
+    }
+
+    Vector2 direction = delta / currentLength;
+
+    error *= stiffness;
+
+    deltaA = direction * error * particleA->inverseMass;
+    return true;
+}
+
+inline float PinConstraint::Solve()
+{
+    Vector2 deltaA;
+    float residual;
+    if (ComputeCorrection(deltaA, residual))
+        particleA->position += deltaA;
+    return residual;
+}
+
+inline bool PinConstraint::ComputeXpbdCorrection(float inverseDt2, Vector2 &deltaA, float &residual)
+{
+    residual = 0.0f;
+    if (particleA->inverseMass <= 0.0f) return false;
+
+    Vector2 delta = particleA->position - pin;
+    float currentLength = delta.Length();
+    float error = currentLength - restLength;
+
+    if (currentLength < 1e-6f) return false;
+
+    float alpha = compliance * inverseDt2;
+    float deltaLambda = (-error - alpha * lambda) / (particleA->inverseMass + alpha);
+    lambda += deltaLambda;
+
+    deltaA = delta * (deltaLambda * particleA->inverseMass / currentLength);
+    residual = std::abs(error);
+    return true;
+}
+
+inline float PinConstraint::SolveXpbd(float inverseDt2)
+{
+    Vector2 deltaA;
+    float residual;
+    if (ComputeXpbdCorrection(inverseDt2, deltaA, residual))
+        particleA->position += deltaA;
+    return residual;
+}
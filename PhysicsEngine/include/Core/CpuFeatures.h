@@ -0,0 +1,15 @@
+#pragma once
+
+// Livelli SIMD in ordine crescente: il kernel sceglie il piu alto disponibile
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX
+};
+
+class CpuFeatures {
+public:
+    // Rilevato una volta a runtime (CPUID + supporto del sistema operativo per AVX)
+    static SimdLevel GetSimdLevel();
+    static const char *GetName(SimdLevel level);
+};
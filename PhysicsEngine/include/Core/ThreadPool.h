@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+// Pool di thread fisso per cicli paralleli brevi e ripetuti (i colori del
+// solver). Il chiamante lavora insieme ai worker e ParallelFor ritorna solo
+// a lavoro finito. I worker aspettano un po' attivamente prima di dormire:
+// tra un colore e l'altro passano pochi microsecondi.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    // Lavoro corrente, pubblicato da generation
+    const std::function<void(size_t, size_t)> *job;
+    size_t jobCount;
+    size_t chunkSize;
+    std::atomic<size_t> nextChunk;
+    std::atomic<unsigned int> generation;
+    std::atomic<unsigned int> pending;        // Worker non ancora usciti dal lavoro corrente
+    bool stopping;
+
+    void WorkerLoop();
+    void RunChunks();
+
+public:
+    // threadCount conta anche il chiamante: 1 = nessun worker, tutto inline
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // job(begin, end) su blocchi disgiunti di [0, count). Sotto minParallel
+    // elementi non vale la sincronizzazione: gira tutto sul chiamante.
+    void ParallelFor(size_t count, const std::function<void(size_t, size_t)> &job, size_t minParallel = 64);
+
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+};
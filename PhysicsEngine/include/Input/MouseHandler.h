@@ -2,6 +2,7 @@
 #include "Math/Vector2.h"
 #include "Physics/RigidBody.h"
 #include "Physics/PhysicsWorld.h"
+#include <vector>
 
 class MouseHandler {
 private:
@@ -11,6 +12,7 @@ private:
 
     float dragStiffness;             // Costante elastica della "molla" del drag
     float dragDamping;
+    std::vector<RigidBody *> pickResults;   // Riusato a ogni click
 
     // Helper privato: trova quale corpo  sotto il cursore
     RigidBody *FindBodyAtPosition(const Vector2 &worldPos, PhysicsWorld &world);
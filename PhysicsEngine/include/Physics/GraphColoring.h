@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Colorazione greedy degli elementi del solver (contatti e vincoli): due
+// elementi dello stesso colore non condividono nessun corpo dinamico, quindi
+// un colore si risolve in parallelo senza lock. Dentro un colore gli elementi
+// restano nell'ordine di inserimento: a parita di colorazione il risultato
+// non dipende dal numero di thread.
+class GraphColoring {
+public:
+    static const int maxColors = 64;  // Un bit per colore nella maschera del corpo
+    static const int fixedBody = -1;  // Corpo che il solver non sposta: non crea conflitti
+
+private:
+    std::vector<uint64_t> bodyMasks;               // Colori gia usati da ogni corpo
+    std::vector<std::vector<unsigned int>> colors;
+    std::vector<unsigned int> overflow;            // Oltre maxColors: risolti in serie
+    size_t colorCount;
+
+public:
+    GraphColoring();
+
+    // Svuota la colorazione (i vettori tengono la capacita)
+    void Begin(size_t bodyCount);
+
+    // Assegna all'elemento item il primo colore libero per entrambi i corpi
+    // (indici da 0 a bodyCount - 1, oppure fixedBody)
+    void Add(unsigned int item, int bodyA, int bodyB);
+
+    size_t GetColorCount() const { return colorCount; }
+    const std::vector<unsigned int> &GetColor(size_t color) const { return colors[color]; }
+    const std::vector<unsigned int> &GetOverflow() const { return overflow; }
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+class RigidBody;
+
+// Isola: corpi collegati da coppie candidate o vincoli, risolti insieme.
+// Gli intervalli indicizzano gli array di IslandBuilder.
+struct Island {
+    size_t bodyBegin, bodyEnd;              // In GetBodies()
+    size_t pairBegin, pairEnd;              // In GetPairs(): pairIndex di PairBuckets, crescenti
+    size_t constraintBegin, constraintEnd;  // In GetConstraints(): indice del vincolo nel mondo
+    int iterations;                         // Iterazioni massime del solver per questa isola
+    int iterationsUsed;                     // Fatte nell'ultimo step (meno se converge prima)
+    float residual;                         // Errore massimo dell'ultima iterazione fatta
+
+    size_t GetBodyCount() const { return bodyEnd - bodyBegin; }
+    size_t GetPairCount() const { return pairEnd - pairBegin; }
+    size_t GetConstraintCount() const { return constraintEnd - constraintBegin; }
+    size_t GetItemCount() const { return GetPairCount() + GetConstraintCount(); }
+};
+
+// Statistiche per isola dell'ultimo step, per il profiling
+struct IslandStats {
+    size_t bodyCount;
+    size_t pairCount;        // Coppie candidate del broadphase
+    size_t contactCount;     // Coppie davvero in contatto nello step
+    size_t constraintCount;
+    int iterations;          // Iterazioni fatte
+    float residual;          // Penetrazione o errore di vincolo massimo all'ultima iterazione
+};
+
+// Union-find sui corpi dinamici (solverIndex) attraverso coppie e vincoli.
+// I corpi fissi (indice negativo) non uniscono isole: un pavimento toccato
+// da tutti non fa del mondo un'unica isola. Le isole escono nell'ordine del
+// loro primo corpo nel mondo, gli elementi nell'ordine di inserimento.
+class IslandBuilder {
+private:
+    std::vector<int> parent;
+    std::vector<int> pairNodes;        // Per coppia: un corpo dinamico, -1 se nessuno
+    std::vector<int> constraintNodes;
+    std::vector<int> islandOfRoot;
+
+    std::vector<Island> islands;
+    std::vector<RigidBody *> bodies;
+    std::vector<unsigned int> pairs;
+    std::vector<unsigned int> constraints;
+
+    int Find(int node);
+    void Union(int a, int b);
+
+public:
+    // nodeCount = corpi con solverIndex valido
+    void Begin(size_t nodeCount);
+
+    // Nell'ordine degli indici: la coppia i-esima e il vincolo i-esimo
+    void AddPair(int nodeA, int nodeB);
+    void AddConstraint(int nodeA, int nodeB);
+
+    // Raggruppa corpi ed elementi per isola, tutte con defaultIterations
+    void Build(const std::vector<std::unique_ptr<RigidBody>> &worldBodies, int defaultIterations);
+
+    std::vector<Island> &GetIslands() { return islands; }
+    const std::vector<Island> &GetIslands() const { return islands; }
+    const std::vector<RigidBody *> &GetBodies() const { return bodies; }
+    const std::vector<unsigned int> &GetPairs() const { return pairs; }
+    const std::vector<unsigned int> &GetConstraints() const { return constraints; }
+};
@@ -3,51 +3,267 @@
 #include "Collision/CollisionDetection.h"
 #include "Constraints/DistanceConstraints.h"
 #include "Constraints/PinConstraint.h"
-#include "Collision/Quadtree.h"
+#include "Constraints/ConstraintArray.h"
+#include "Constraints/DistanceBatch.h"
+#include "Constraints/ChainSolver.h"
+#include "Constraints/MultigridSolver.h"
+#include "Collision/Broadphase.h"
+#include "Collision/CircleBatch.h"
+#include "Collision/Narrowphase.h"
+#include "Collision/ContactCache.h"
+#include "Physics/GraphColoring.h"
+#include "Physics/IslandBuilder.h"
+#include "Core/ThreadPool.h"
 #include <vector>
 #include <memory>
-#include <set>
+#include <unordered_map>
 
 class PhysicsWorld {
 private:
     //int nextBodyId = 0;  // NUOVO: contatore ID
     std::vector<std::unique_ptr<RigidBody>> bodies;
-    std::vector<std::unique_ptr<Constraint>> constraints;
-    std::unique_ptr<QuadTree> quadTree;
+    ConstraintArray<DistanceConstraint, ConstraintType::DISTANCE> distanceConstraints;
+    ConstraintArray<PinConstraint, ConstraintType::PIN> pinConstraints;
+    std::unique_ptr<Broadphase> broadphase;
+    std::vector<BroadphasePair> broadphasePairs;  // Coppie candidate, calcolate una volta per step
+    PairBuckets pairBuckets;                      // Le stesse coppie divise per tipo di forme
+    ContactCache contactCache;                    // Contatti persistenti tra gli step
+    std::vector<CollisionInfo> firstContacts;     // Per pairIndex: primo contatto dello step (restituzione)
+    int solverIterations;                         // Con solverTolerance > 0 e il massimo
+    float solverTolerance;                        // 0 = sempre solverIterations iterazioni
+    int lastIterations;                           // Massimo tra le isole dell'ultimo step
+    float lastResidual;
+    bool warmStarting;
+
+    // Isole: corpi collegati da coppie o vincoli, risolte indipendentemente
+    IslandBuilder islandBuilder;
+    std::vector<IslandStats> islandStats;
+    std::vector<BroadphasePair> solverPairs;      // Per pairIndex, accesso diretto da isole e colori
+    int solverNodeCount;                          // Corpi con solverIndex valido
+
+    // Con piu di un thread: isole piccole in parallelo, le grandi a colori
+    std::unique_ptr<ThreadPool> threadPool;
+    GraphColoring solverColoring;
+    std::vector<size_t> parallelIslands;
+    size_t lastColorCount;
+    static constexpr size_t coloredIslandItems = 256; // Da qui in su un'isola va a colori sui thread
+
+    // Vincoli di distanza a lotti SIMD, solo nelle isole risolte su un thread
+    // con almeno coloredIslandItems elementi. Un solver per isola, ritrovato
+    // a ogni step dal primo vincolo dell'isola: ognuna riusa la sua colorazione.
+    bool constraintBatching;
+    bool batchFastInverseSqrt;
+    std::unordered_map<unsigned int, DistanceBatchSolver> distanceBatches;
+    std::vector<DistanceBatchSolver *> islandBatches;  // Per isola dello step, nullptr se non a lotti
+    std::vector<unsigned int> islandSolverKeys;   // Scratch di AssignIslandSolvers
+
+    // Catene (corde, pendoli) risolte in modo diretto, una soluzione per
+    // iterazione; il resto dei vincoli dell'isola resta a Gauss-Seidel
+    bool chainSolving;
+    ChainSolver chainSolver;
+
+    // Griglie di vincoli: prima della passata sulle distanze, una correzione
+    // sui livelli grossolani (V-ciclo). Stesse isole dei lotti SIMD, solo PBD,
+    // e come loro una gerarchia per isola con la stessa chiave.
+    bool multigridSolving;
+    std::unordered_map<unsigned int, MultigridSolver> multigrids;
+    std::vector<MultigridSolver *> islandMultigrids;  // Per isola dello step, nullptr senza livelli
+
+    // XPBD: lo step diviso in sottopassi da una iterazione, vincoli con compliance
+    struct SubstepStart {
+        RigidBody *body;
+        Vector2 position, oldPosition;
+        float angle, angularVelocity;
+    };
+    int xpbdSubsteps;                             // 0 = PBD con stiffness e solverIterations
+    float xpbdInverseDt2;                         // 1 / h^2 del sottopasso
+    std::vector<SubstepStart> substepStarts;      // Corpi integrati, come erano a inizio step
+
+    // Jacobi: ogni elemento calcola la sua correzione senza scriverla, poi ogni
+    // corpo somma quelle che lo toccano (media per numero, fattore SOR sui vincoli)
+    struct JacobiCorrection {
+        Vector2 deltaA, deltaB;
+        bool active;                              // Elemento con una correzione in questa iterazione
+        bool contact;                             // Contatto: sposta anche oldPosition (velocita invariata)
+        bool keepVelocity;                        // Falso su un contatto a riposo: oldPosition resta
+    };
+    bool jacobiEnabled;
+    float jacobiRelaxation;
+    std::vector<JacobiCorrection> jacobiCorrections;  // Per elemento: coppie delle isole, poi vincoli
+    std::vector<RigidBody *> jacobiBodies;        // Per solverIndex
+    std::vector<unsigned int> jacobiOffsets;      // Elementi del corpo i: jacobiRefs[offsets[i]..offsets[i + 1])
+    std::vector<unsigned int> jacobiRefs;         // elemento * 2 + lato (0 = A, 1 = B)
+    std::vector<unsigned int> jacobiPairs;        // Coppie di tutte le isole, in pairIndex crescenti
+
+    // Chebyshev: dopo ogni iterazione la posizione e spinta oltre, lungo la
+    // differenza con l'iterata di due iterazioni prima, con omega crescente.
+    // oldPosition segue la stessa formula: nel solver la muovono solo i
+    // contatti che tengono la velocita, e la loro spinta resta spostamento.
+    struct ChebyshevIterate {
+        Vector2 previous, current;                // Iterate k - 1 e k
+        Vector2 previousOld, currentOld;          // oldPosition alle stesse iterate
+        float push;                               // Frazione della spinta: 1, o chebyshevContactPush
+    };
+    static constexpr float chebyshevContactPush = 0.5f;  // Corpi in una coppia: a spinta intera un mucchio non si ferma
+    bool chebyshevEnabled;
+    float chebyshevRadius;                        // Stima del raggio spettrale del solver (0-1)
+    int chebyshevWarmup;                          // Iterazioni iniziali senza accelerazione
+    std::vector<ChebyshevIterate> chebyshevIterates;  // Per solverIndex
+
+    // Sleeping: le isole ferme escono dalla simulazione e finiscono nel
+    // broadphase statico finche un corpo sveglio, un vincolo o una forza non le tocca
+    bool sleepingEnabled;
+    float sleepTolerance;                         // Spostamento massimo per contare come fermo
+    float timeToSleep;                            // Secondi da fermo prima di dormire
+    // Un gruppo ricorda i corpi statici su cui poggia, con la forma che avevano:
+    // se uno sparisce o cambia, il gruppo si sveglia e ricade. Le isole che si
+    // addormentano accanto a un gruppo ci entrano, cosi una pila dorme e si sveglia intera.
+    struct SleepSupport {
+        RigidBody *body;
+        AABB bounds;                              // GetBodyBounds senza margine all'addormentamento
+    };
+    struct SleepGroup {
+        std::vector<RigidBody *> bodies;
+        std::vector<SleepSupport> supports;
+    };
+    std::vector<SleepGroup> sleepGroups;          // Isole addormentate, svegliate tutte insieme
+    std::vector<int> freeSleepGroups;
+    size_t sleepingBodyCount;
+    bool sleepingChanged;                         // Qualcuno si e svegliato: il broadphase va rifatto
+    BroadphaseType broadphaseType;
+    bool broadphaseDirty;                         // Corpi creati o mossi dopo l'ultimo Update del broadphase
+    std::vector<RigidBody *> queryCandidates;     // Scratch dei raycast, riusato
+
+    // Geometria statica: struttura separata, ricostruita solo quando cambia
+    std::unique_ptr<Broadphase> staticBroadphase;
+    std::vector<RigidBody *> staticBodies;        // Nell'ordine di bodies, all'ultima build
+    std::vector<RigidBody *> dynamicBodies;       // Rifatta a ogni step
+    std::vector<RigidBody *> staticCandidates;    // Scratch di FindStaticPairs
+    std::vector<RigidBody *> continuousCandidates;  // Scratch della CCD
+    bool staticsDirty;
+
+    bool circlePruning;                           // Filtro SIMD delle coppie cerchio-cerchio
+    CircleBatch circleBatch;                      // Coppie cerchio-cerchio del broadphase, da filtrare
+    std::vector<uint32_t> circleLanes;            // Corsie rimaste dopo il filtro
     Vector2 gravity;
     float fixedTimeStep;        // Timestep fisso per stabilit
     float timeAccumulator;      // Accumula tempo per timestep fisso
 
-    bool DetectCollision(RigidBody *a, RigidBody *b, CollisionInfo &info);
     void ApplyRestitution(const std::vector<CollisionInfo> &collisions);
     void ResolveCollision(const CollisionInfo &info);
-    std::set<std::pair<RigidBody *, RigidBody *>> activeCollisions;
-    void ClearPreviousCollisions();
+    void WarmStartContact(const CollisionInfo &info, size_t pairIndex);
+    float SolveContact(const CollisionInfo &info, size_t pairIndex, bool firstIteration);
+    float SolveConstraint(unsigned int index);
+    void IntegrateBodies(float dt);
+    void BuildIslands();
+    void SolveIslands();
+    void SolveSubsteps();
+    void SolveJacobi();
+    float ChebyshevOmega(int iteration, float omega) const;
+    void BeginChebyshev(RigidBody *const *begin, RigidBody *const *end, const unsigned int *pairBegin, const unsigned int *pairEnd);
+    void ApplyChebyshev(RigidBody *const *begin, RigidBody *const *end, float omega);
+    void GetJacobiItemBodies(size_t item, RigidBody *&bodyA, RigidBody *&bodyB) const;
+    bool ComputeContactCorrection(const CollisionInfo &info, Vector2 &deltaA, Vector2 &deltaB) const;
+    template <typename Solver>
+    void AssignIslandSolvers(std::unordered_map<unsigned int, Solver> &solvers, std::vector<Solver *> &islandSolvers, bool enabled);
+    void SolveIsland(Island &island);
+    void SolveIslandColored(Island &island);
+    template <typename ContactSolver>
+    float SolveColored(ContactSolver &solveContact, bool withConstraints);
+    void UpdateIslandStats();
+    void FindAllPairs();
+    void WakeGroup(int group);
+    void WakeDisturbedGroups();
+    void WakeSupportedGroups(const RigidBody *support);  // nullptr: ogni gruppo con un appoggio cambiato
+    void MergeSleepGroup(int from, int into);
+    void WakeTouchedBodies();
+    void UpdateSleeping();
+    void SyncBroadphase();
+    void QueryBroadphase(const AABB &range, std::vector<RigidBody *> &found);
+    void ClassifyBodies();
+    void FindStaticPairs();
+    void PruneCirclePairs();
+    bool SolveContinuousCollisions(std::vector<CollisionInfo> &collisions);
 
 public:
-    PhysicsWorld();
+    PhysicsWorld(BroadphaseType type = BroadphaseType::QUADTREE);
 
     // Gestione RigidBody
     RigidBody *CreateRigidBody(const Vector2 &position, float mass);
-    DistanceConstraint *CreateDistanceConstraint(RigidBody *bodyA, RigidBody *bodyB, float stiff);
-    PinConstraint *CreatePinConstraint(RigidBody *body, const Vector2 &pin, float stiff);
+    ConstraintHandle CreateDistanceConstraint(RigidBody *bodyA, RigidBody *bodyB, float stiff);
+    ConstraintHandle CreatePinConstraint(RigidBody *body, const Vector2 &pin, float stiff);
+    bool SetConstraintCompliance(const ConstraintHandle &handle, float compliance);  // XPBD, m/N; false se il vincolo non c'e piu
+    bool RemoveConstraint(const ConstraintHandle &handle);
     void RemoveRigidBody(RigidBody *body);
     void Clear();
 
     // Impostazioni mondo fisico
     void SetGravity(const Vector2 &g);
     void SetTimeStep(float timeStep);
+    void SetPersistentQuadTree(bool enabled);
+    void SetBroadphaseMargin(float margin);     // Allargamento AABB delle coppie candidate
+    void MarkStaticGeometryDirty();             // Da chiamare dopo aver spostato o ridimensionato corpi statici
+    void SetSolverIterations(int iterations);
+    void SetSolverTolerance(float tolerance);   // > 0: un'isola smette quando penetrazioni ed errori scendono sotto
+    void SetXpbdSubsteps(int substeps);         // > 0: XPBD, substeps sottopassi da una iterazione; 0 = PBD
+    void SetJacobiSolver(bool enabled, float relaxation = 1.0f);  // Correzioni accumulate e applicate a fine iterazione; relaxation > 1 solo sui vincoli
+    void SetChebyshevAcceleration(bool enabled, float spectralRadius = 0.9f, int warmupIterations = 2);  // Iterazioni estrapolate (non XPBD); oltre 0.9 le catene rigide possono divergere
+    void SetWarmStarting(bool enabled);         // Riparte dalle correzioni dello step precedente
+    void SetSolverThreads(int threads);         // 1 = Gauss-Seidel seriale, di piu = colori in parallelo
+    void SetCirclePruning(bool enabled);        // Scarta a lotti (SIMD) le coppie cerchio-cerchio lontane, prima del solver
+    void SetConstraintBatching(bool enabled, bool fastInverseSqrt = false);  // Vincoli di distanza 4/8 alla volta (SIMD)
+    void SetChainSolver(bool enabled);          // Catene di vincoli rigidi risolte in O(n) (non in modalita Jacobi)
+    void SetMultigridSolver(bool enabled);      // Livelli grossolani sulle reti di distanze grandi (non XPBD ne Jacobi)
+    void SetSleepingEnabled(bool enabled);
+    void SetSleepParameters(float tolerance, float time);  // Fermo = entro tolerance per time secondi
+    void WakeBody(RigidBody *body);             // Sveglia il corpo e tutto il suo gruppo
     Vector2 GetGravity() const { return gravity; }
 
     // Simulazione
     void Update(float deltaTime);    // Aggiorna con timestep variabile
     void Step();                     // Un singolo step di simulazione
-    void SolvePositionConstraint(const CollisionInfo &info);
+    void SolvePositionConstraint(const CollisionInfo &info, bool keepVelocity = true);  // false: sposta solo position
     void ApplyRestitution(const CollisionInfo &info);
 
+    // Query spaziali sul broadphase: il vettore viene svuotato e riempito,
+    // a regime non si alloca nulla. Test esatti sulla forma dei corpi.
+    void QueryPoint(const Vector2 &point, std::vector<RigidBody *> &results);
+    void QueryAABB(const AABB &region, std::vector<RigidBody *> &results);
+    void QueryCircle(const Vector2 &center, float radius, std::vector<RigidBody *> &results);
+    bool RayCast(const Vector2 &origin, const Vector2 &end, RaycastHit &hit);         // Colpo piu vicino
+    void RayCastAll(const Vector2 &origin, const Vector2 &end, std::vector<RaycastHit> &hits);  // Ordinati per fraction
+
     // Utility
     size_t GetBodyCount() const { return bodies.size(); }
     const std::vector<std::unique_ptr<RigidBody>> &GetBodies() const { return bodies; }
-    const std::vector<std::unique_ptr<Constraint>> &GetConstraints() const { return constraints; }
+    // Vincoli per tipo, nell'ordine di risoluzione. I puntatori da handle
+    // valgono fino alla prossima creazione o rimozione di un vincolo.
+    DistanceConstraint *GetDistanceConstraint(const ConstraintHandle &handle) { return distanceConstraints.Get(handle); }
+    PinConstraint *GetPinConstraint(const ConstraintHandle &handle) { return pinConstraints.Get(handle); }
+    const std::vector<DistanceConstraint> &GetDistanceConstraints() const { return distanceConstraints.GetItems(); }
+    const std::vector<PinConstraint> &GetPinConstraints() const { return pinConstraints.GetItems(); }
+    size_t GetConstraintCount() const { return distanceConstraints.Size() + pinConstraints.Size(); }
     float GetFixedTimeStep() const { return fixedTimeStep; }
+    int GetQuadTreeRelocations() const;         // Nell'ultimo step
+    size_t GetBroadphasePairCount() const { return pairBuckets.Size(); }
+    size_t GetContactCount() const { return contactCache.GetContactCount(); }
+    int GetSolverIterations() const { return solverIterations; }
+    float GetSolverTolerance() const { return solverTolerance; }
+    int GetXpbdSubsteps() const { return xpbdSubsteps; }
+    bool GetJacobiSolver() const { return jacobiEnabled; }
+    bool GetChebyshevAcceleration() const { return chebyshevEnabled; }
+    int GetLastIterations() const { return lastIterations; }        // Ultimo step, isola che ne ha fatte di piu
+    float GetLastResidual() const { return lastResidual; }          // Ultimo step, massimo tra le isole
+    int GetSolverThreads() const;
+    size_t GetSolverColorCount() const { return lastColorCount; }   // Massimo tra le isole a colori dell'ultimo step
+    bool GetCirclePruning() const { return circlePruning; }
+    bool GetConstraintBatching() const { return constraintBatching; }
+    bool GetChainSolver() const { return chainSolving; }
+    size_t GetChainCount() const { return chainSolving && !jacobiEnabled ? chainSolver.GetChainCount() : 0; }  // Catene trovate nell'ultimo step
+    bool GetMultigridSolver() const { return multigridSolving; }
+    size_t GetMultigridLevelCount() const;      // Gerarchia piu profonda tra le isole dell'ultimo step
+    size_t GetIslandCount() const { return islandStats.size(); }   // Solo isole sveglie
+    size_t GetSleepingBodyCount() const { return sleepingBodyCount; }
+    const std::vector<IslandStats> &GetIslandStats() const { return islandStats; }  // Ultimo step, nell'ordine delle isole
+    BroadphaseType GetBroadphaseType() const { return broadphaseType; }
 };
\ No newline at end of file
@@ -6,6 +6,8 @@ enum class ShapeType {
     AABB // Axis-Aligned Bounding Box
 };
 
+constexpr int ShapeTypeCount = 2;  // Numero di valori di ShapeType
+
 class RigidBody {
 public:
     ShapeType shapeType;
@@ -39,6 +41,7 @@ public:
     bool isStatic;                 // true = massa infinita, non si muove
     bool isActive;                 // true = partecipa alla simulazione
     bool isSleeping;               // true = non subisce la gravit
+    bool isContinuous;             // true = CCD: movimento controllato con sweep, niente tunneling
 
 private:
     // Accumulo delle forze
@@ -46,6 +49,10 @@ private:
     float torqueAccumulator;       // Somma di tutti i momenti applicati
 public:
     Vector2 oldPosition;           // Posizione precedente per verlet
+    int solverIndex;               // Nodo nella colorazione del solver, -1 se il solver non lo sposta
+    Vector2 restPosition;          // Dove il corpo ha iniziato a stare fermo
+    float sleepTime;               // Secondi passati vicino a restPosition
+    int sleepGroup;                // Gruppo addormentato nel mondo, -1 se sveglio
 
 public:
     // Costruttori
@@ -67,6 +74,7 @@ public:
     void SetRadius(float newRadius);
     void SetInertia(float newInertia);
     void SetStatic(bool static_state);
+    void SetContinuous(bool enabled);
 
     // Metodi di simulazione
     void Integrate(float deltaTime);    // Integrazione di Eulero
@@ -85,6 +93,7 @@ public:
     bool IsStatic() const { return isStatic; }
     bool IsActive() const { return isActive; }
     bool IsSleeping() const { return isSleeping; }
+    bool IsContinuous() const { return isContinuous; }
     float GetMinX() const { return position.x - width / 2; }
     float GetMaxX() const { return position.x + width / 2; }
     float GetMinY() const { return position.y - height / 2; }
@@ -0,0 +1,15 @@
+#include "Collision/Broadphase.h"
+
+Broadphase::Broadphase(float margin) : margin(margin)
+{
+}
+
+Broadphase::~Broadphase() = default;
+
+AABB Broadphase::GetBodyBounds(const RigidBody *body, float margin)
+{
+    if (body->shapeType == ShapeType::CIRCLE)
+        return AABB(body->position, body->radius + margin, body->radius + margin);
+
+    return AABB(body->position, body->width / 2.0f + margin, body->height / 2.0f + margin);
+}
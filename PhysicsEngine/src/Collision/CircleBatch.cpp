@@ -0,0 +1,117 @@
+#include "Collision/CircleBatch.h"
+#include "Collision/CollisionDetection.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX_TARGET
+#define SSE2_TARGET
+#else
+#define AVX_TARGET __attribute__((target("avx")))
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+#endif
+
+void CircleBatch::Clear()
+{
+    ax.clear(); ay.clear(); ar.clear();
+    bx.clear(); by.clear(); br.clear();
+}
+
+void CircleBatch::Add(const RigidBody *a, const RigidBody *b)
+{
+    ax.push_back(a->position.x); ay.push_back(a->position.y); ar.push_back(a->radius);
+    bx.push_back(b->position.x); by.push_back(b->position.y); br.push_back(b->radius);
+}
+
+// Distanza massima tra i centri per restare: ra + rb + slack - soglia di
+// CircleVsCircle, confrontata al quadrato (niente radice)
+static inline float Reach(float radiusSum, float slack)
+{
+    return std::max(radiusSum + slack - CollisionDetection::circleContactThreshold, 0.0f);
+}
+
+static void PruneScalar(const CircleBatch &batch, uint32_t begin, float slack, std::vector<uint32_t> &lanes)
+{
+    uint32_t count = static_cast<uint32_t>(batch.Size());
+    for (uint32_t i = begin; i < count; i++) {
+        float dx = batch.bx[i] - batch.ax[i];
+        float dy = batch.by[i] - batch.ay[i];
+        float reach = Reach(batch.ar[i] + batch.br[i], slack);
+        if (dx * dx + dy * dy < reach * reach)
+            lanes.push_back(i);
+    }
+}
+
+#ifdef PHYSICS_SIMD
+
+static inline void EmitLanes(uint32_t base, int mask, std::vector<uint32_t> &lanes)
+{
+    for (uint32_t lane = base; mask; lane++, mask >>= 1) {
+        if (mask & 1)
+            lanes.push_back(lane);
+    }
+}
+
+SSE2_TARGET static uint32_t PruneSSE2(const CircleBatch &batch, float slack, std::vector<uint32_t> &lanes)
+{
+    __m128 offset4 = _mm_set1_ps(slack - CollisionDetection::circleContactThreshold);
+    __m128 zero4 = _mm_setzero_ps();
+    uint32_t count = static_cast<uint32_t>(batch.Size()) & ~3u;
+    for (uint32_t i = 0; i < count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&batch.bx[i]), _mm_loadu_ps(&batch.ax[i]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&batch.by[i]), _mm_loadu_ps(&batch.ay[i]));
+        __m128 reach = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(&batch.ar[i]), _mm_loadu_ps(&batch.br[i])), offset4), zero4);
+
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(d2, _mm_mul_ps(reach, reach)));
+
+        // Tipicamente quasi tutte le corsie vengono scartate qui
+        if (mask)
+            EmitLanes(i, mask, lanes);
+    }
+    return count;
+}
+
+AVX_TARGET static uint32_t PruneAVX(const CircleBatch &batch, float slack, std::vector<uint32_t> &lanes)
+{
+    __m256 offset8 = _mm256_set1_ps(slack - CollisionDetection::circleContactThreshold);
+    __m256 zero8 = _mm256_setzero_ps();
+    uint32_t count = static_cast<uint32_t>(batch.Size()) & ~7u;
+    for (uint32_t i = 0; i < count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&batch.bx[i]), _mm256_loadu_ps(&batch.ax[i]));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&batch.by[i]), _mm256_loadu_ps(&batch.ay[i]));
+        __m256 reach = _mm256_max_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(&batch.ar[i]), _mm256_loadu_ps(&batch.br[i])), offset8), zero8);
+
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+        if (mask)
+            EmitLanes(i, mask, lanes);
+    }
+    return count;
+}
+
+#endif
+
+void CircleBatchKernel::Prune(const CircleBatch &batch, std::vector<uint32_t> &lanes, float slack)
+{
+    Prune(batch, lanes, CpuFeatures::GetSimdLevel(), slack);
+}
+
+void CircleBatchKernel::Prune(const CircleBatch &batch, std::vector<uint32_t> &lanes, SimdLevel level, float slack)
+{
+    lanes.clear();
+    uint32_t done = 0;
+
+#ifdef PHYSICS_SIMD
+    if (level == SimdLevel::AVX)
+        done = PruneAVX(batch, slack, lanes);
+    else if (level == SimdLevel::SSE2)
+        done = PruneSSE2(batch, slack, lanes);
+#endif
+
+    // Coda (o tutto il lotto senza SIMD)
+    PruneScalar(batch, done, slack, lanes);
+}
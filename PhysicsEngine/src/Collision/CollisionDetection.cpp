@@ -1,20 +1,27 @@
 #include "Collision/CollisionDetection.h"
 #include <algorithm>
+#include <cmath>
 
 bool CollisionDetection::CircleVsCircle(RigidBody *a, RigidBody *b, CollisionInfo &info)
 {
-	float distance = Vector2::Distance(a->position, b->position);
-	float penetration = (a->radius + b->radius) - distance;
+	// Scarto sul quadrato della distanza, come CircleBatchKernel::Prune: la
+	// radice serve solo alle coppie che si toccano, e una basta anche per la normale
+	Vector2 delta = b->position - a->position;
+	float distanceSquared = delta.LengthSquared();
+	float reach = a->radius + b->radius - circleContactThreshold;
 
-	const float collisionThreshold = 0.001f;  // NUOVO: ignora micro-sovrapposizioni
+	if (reach > 0.0f && distanceSquared < reach * reach) {
+		float distance = std::sqrt(distanceSquared);
+		float penetration = (a->radius + b->radius) - distance;
 
-	if (penetration > collisionThreshold) {  // Cambiato da > 0
-		info.bodyA = a;
-		info.bodyB = b;
-		info.normal = (b->position - a->position).Normalized();
-		info.penetration = penetration;
-		info.hasCollision = true;
-		return true;
+		if (penetration > circleContactThreshold) {  // Cambiato da > 0
+			info.bodyA = a;
+			info.bodyB = b;
+			info.normal = distance < 1e-6f ? Vector2::ZERO : Vector2(delta.x / distance, delta.y / distance);  // Come Normalized()
+			info.penetration = penetration;
+			info.hasCollision = true;
+			return true;
+		}
 	}
 
 	info.bodyA = a;
@@ -88,3 +95,149 @@ bool CollisionDetection::AABBvsAABB(RigidBody *a, RigidBody *b, CollisionInfo &i
 	info.hasCollision = true;
 	return true;
 }
+
+bool CollisionDetection::PointInBody(const Vector2 &point, const RigidBody *body)
+{
+	if (body->shapeType == ShapeType::CIRCLE)
+		return Vector2::DistanceSquared(body->position, point) <= body->radius * body->radius;
+
+	return point.x >= body->GetMinX() && point.x <= body->GetMaxX() && point.y >= body->GetMinY() && point.y <= body->GetMaxY();
+}
+
+bool CollisionDetection::CircleOverlapsBody(const Vector2 &center, float radius, const RigidBody *body)
+{
+	if (body->shapeType == ShapeType::CIRCLE) {
+		float reach = radius + body->radius;
+		return Vector2::DistanceSquared(body->position, center) <= reach * reach;
+	}
+
+	// Punto del box piu vicino al centro
+	Vector2 closest(std::clamp(center.x, body->GetMinX(), body->GetMaxX()), std::clamp(center.y, body->GetMinY(), body->GetMaxY()));
+	return Vector2::DistanceSquared(closest, center) <= radius * radius;
+}
+
+bool CollisionDetection::AABBOverlapsBody(const AABB &box, const RigidBody *body)
+{
+	if (body->shapeType == ShapeType::CIRCLE) {
+		Vector2 closest(std::clamp(body->position.x, box.GetMinX(), box.GetMaxX()), std::clamp(body->position.y, box.GetMinY(), box.GetMaxY()));
+		return Vector2::DistanceSquared(closest, body->position) <= body->radius * body->radius;
+	}
+
+	return box.GetMinX() <= body->GetMaxX() && body->GetMinX() <= box.GetMaxX() &&
+		box.GetMinY() <= body->GetMaxY() && body->GetMinY() <= box.GetMaxY();
+}
+
+bool CollisionDetection::RayVsCircle(const Vector2 &origin, const Vector2 &d, const Vector2 &center, float radius, float &t, Vector2 &normal)
+{
+	// |origin + t*d - c|^2 = r^2, prima radice in [0, 1]
+	float a = d.LengthSquared();
+	Vector2 f = origin - center;
+	float b = f.Dot(d);
+	float c = f.LengthSquared() - radius * radius;
+	float disc = b * b - a * c;
+	if (a <= 0.0f || disc < 0.0f)
+		return false;
+
+	t = (-b - std::sqrt(disc)) / a;
+	if (t < 0.0f || t > 1.0f)
+		return false;
+
+	normal = (origin + d * t - center) / radius;
+	return true;
+}
+
+bool CollisionDetection::RayVsBox(const Vector2 &origin, const Vector2 &d, const Vector2 &min, const Vector2 &max, float &t, Vector2 &normal)
+{
+	// Slab test: intervallo [tEnter, tExit] dentro entrambe le fasce
+	float tEnter = 0.0f, tExit = 1.0f;
+	normal = Vector2::ZERO;
+
+	for (int axis = 0; axis < 2; axis++) {
+		if (std::fabs(d[axis]) < 1e-8f) {
+			if (origin[axis] < min[axis] || origin[axis] > max[axis])
+				return false;
+			continue;
+		}
+
+		float inv = 1.0f / d[axis];
+		float t1 = (min[axis] - origin[axis]) * inv;
+		float t2 = (max[axis] - origin[axis]) * inv;
+		float side = -1.0f;  // Si entra dalla faccia min
+		if (t1 > t2) {
+			std::swap(t1, t2);
+			side = 1.0f;
+		}
+
+		if (t1 > tEnter) {
+			tEnter = t1;
+			normal = Vector2::ZERO;
+			normal[axis] = side;
+		}
+		tExit = std::min(tExit, t2);
+		if (tEnter > tExit)
+			return false;
+	}
+
+	// Normale nulla: l'origine era gia dentro, nessuna faccia attraversata
+	t = tEnter;
+	return normal.LengthSquared() > 0.0f;
+}
+
+bool CollisionDetection::RayVsBody(const Vector2 &origin, const Vector2 &end, RigidBody *body, RaycastHit &hit)
+{
+	Vector2 d = end - origin;
+
+	if (PointInBody(origin, body)) {
+		hit.body = body;
+		hit.point = origin;
+		hit.normal = d.LengthSquared() > 0.0f ? d.Normalized() * -1.0f : Vector2::ZERO;
+		hit.fraction = 0.0f;
+		return true;
+	}
+
+	float t;
+	Vector2 normal;
+	bool found = body->shapeType == ShapeType::CIRCLE
+		? RayVsCircle(origin, d, body->position, body->radius, t, normal)
+		: RayVsBox(origin, d, Vector2(body->GetMinX(), body->GetMinY()), Vector2(body->GetMaxX(), body->GetMaxY()), t, normal);
+	if (!found)
+		return false;
+
+	hit.body = body;
+	hit.point = origin + d * t;
+	hit.normal = normal;
+	hit.fraction = t;
+	return true;
+}
+
+bool CollisionDetection::SweepBody(const RigidBody *moving, const Vector2 &from, const Vector2 &to, RigidBody *other, RaycastHit &hit)
+{
+	// Somma di Minkowski: il centro di moving come raggio contro other
+	// allargato della forma di moving. Cerchio contro box usa il box
+	// allargato del raggio (angoli squadrati): al peggio l'impatto e anticipato.
+	Vector2 d = to - from;
+	float t;
+	Vector2 normal;
+	bool found;
+
+	if (moving->shapeType == ShapeType::CIRCLE && other->shapeType == ShapeType::CIRCLE) {
+		found = RayVsCircle(from, d, other->position, moving->radius + other->radius, t, normal);
+	}
+	else {
+		Vector2 reach = moving->shapeType == ShapeType::CIRCLE
+			? Vector2(moving->radius, moving->radius)
+			: Vector2(moving->width * 0.5f, moving->height * 0.5f);
+		Vector2 half = other->shapeType == ShapeType::CIRCLE
+			? Vector2(other->radius, other->radius)
+			: Vector2(other->width * 0.5f, other->height * 0.5f);
+		found = RayVsBox(from, d, other->position - half - reach, other->position + half + reach, t, normal);
+	}
+	if (!found)
+		return false;
+
+	hit.body = other;
+	hit.point = from + d * t;
+	hit.normal = normal;
+	hit.fraction = t;
+	return true;
+}
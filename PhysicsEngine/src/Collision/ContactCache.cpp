@@ -0,0 +1,90 @@
+#include "Collision/ContactCache.h"
+#include <functional>
+
+size_t ContactCache::KeyHash::operator()(const Key &key) const
+{
+    size_t a = std::hash<RigidBody *>()(key.bodyA);
+    size_t b = std::hash<RigidBody *>()(key.bodyB);
+    return a ^ (b + 0x9e3779b9 + (a << 6) + (a >> 2));
+}
+
+ContactCache::ContactCache() : stamp(0)
+{
+}
+
+void ContactCache::BeginStep(const PairBuckets &pairs)
+{
+    stamp++;
+    slots.assign(pairs.Size(), nullptr);
+    slotPairs.resize(pairs.Size());
+    fresh.resize(pairs.Size());
+
+    pairs.ForEachPair([&](const BroadphasePair &pair, size_t index) {
+        slotPairs[index] = pair;
+
+        auto it = contacts.find({ pair.bodyA, pair.bodyB });
+        if (it == contacts.end())
+            return;
+
+        // Solo i contatti dello step appena concluso valgono come warm start
+        CachedContact &contact = it->second;
+        contact.previous = contact.lastTouched + 1 == stamp ? contact.accumulated : 0.0f;
+        contact.accumulated = 0.0f;
+        slots[index] = &contact;
+    });
+}
+
+bool ContactCache::Accumulate(size_t pairIndex, const CollisionInfo &info, float correction)
+{
+    CachedContact *contact = slots[pairIndex];
+    if (!contact) {
+        contact = &fresh[pairIndex];
+        *contact = { info.normal, 0.0f, 0.0f, 0, 0 };
+        slots[pairIndex] = contact;
+    }
+
+    bool first = contact->lastTouched != stamp;
+    if (first)
+        contact->age = contact->lastTouched + 1 == stamp ? contact->age + 1 : 1;
+
+    contact->normal = info.normal;
+    contact->accumulated += correction;
+    contact->lastTouched = stamp;
+    return first;
+}
+
+void ContactCache::EndStep()
+{
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i] == &fresh[i])
+            contacts[{ slotPairs[i].bodyA, slotPairs[i].bodyB }] = fresh[i];
+    }
+
+    for (auto it = contacts.begin(); it != contacts.end();) {
+        if (it->second.lastTouched != stamp)
+            it = contacts.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ContactCache::RemoveBody(const RigidBody *body)
+{
+    for (auto it = contacts.begin(); it != contacts.end();) {
+        if (it->first.bodyA == body || it->first.bodyB == body)
+            it = contacts.erase(it);
+        else
+            ++it;
+    }
+    slots.clear();
+    slotPairs.clear();
+    fresh.clear();
+}
+
+void ContactCache::Clear()
+{
+    contacts.clear();
+    slots.clear();
+    slotPairs.clear();
+    fresh.clear();
+}
@@ -0,0 +1,462 @@
+#include "Collision/DynamicAABBTree.h"
+#include <algorithm>
+
+DynamicAABBTree::DynamicAABBTree(float margin, float displacementMultiplier, bool trackPairs)
+    : Broadphase(margin), root(nullNode), freeList(nullNode), displacementMultiplier(displacementMultiplier),
+    trackPairs(trackPairs), updateStamp(0), reinsertCount(0)
+{
+}
+
+DynamicAABBTree::Bounds DynamicAABBTree::Union(const Bounds &a, const Bounds &b)
+{
+    return { std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+}
+
+float DynamicAABBTree::Perimeter(const Bounds &b)
+{
+    return 2.0f * ((b.maxX - b.minX) + (b.maxY - b.minY));
+}
+
+bool DynamicAABBTree::Contains(const Bounds &outer, const Bounds &inner)
+{
+    return outer.minX <= inner.minX && outer.minY <= inner.minY && inner.maxX <= outer.maxX && inner.maxY <= outer.maxY;
+}
+
+bool DynamicAABBTree::Overlaps(const Bounds &a, const Bounds &b)
+{
+    return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY;
+}
+
+uint64_t DynamicAABBTree::PairKey(int proxyA, int proxyB)
+{
+    uint64_t lo = static_cast<uint32_t>(std::min(proxyA, proxyB));
+    uint64_t hi = static_cast<uint32_t>(std::max(proxyA, proxyB));
+    return (hi << 32) | lo;
+}
+
+DynamicAABBTree::Bounds DynamicAABBTree::MakeFatBounds(const RigidBody *body) const
+{
+    AABB tight = GetBodyBounds(body, margin);
+    Bounds fat = { tight.GetMinX(), tight.GetMinY(), tight.GetMaxX(), tight.GetMaxY() };
+
+    // Spostamento Verlet dell'ultimo step: il corpo probabilmente continuera cosi
+    Vector2 d = (body->position - body->oldPosition) * displacementMultiplier;
+    if (d.x < 0.0f) fat.minX += d.x; else fat.maxX += d.x;
+    if (d.y < 0.0f) fat.minY += d.y; else fat.maxY += d.y;
+
+    return fat;
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+    int id;
+    if (freeList != nullNode) {
+        id = freeList;
+        freeList = nodes[id].parent;
+    }
+    else {
+        id = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node &node = nodes[id];
+    node.body = nullptr;
+    node.parent = nullNode;
+    node.child1 = nullNode;
+    node.child2 = nullNode;
+    node.height = 0;
+    node.moved = false;
+    node.dying = false;
+    node.stamp = 0;
+    return id;
+}
+
+void DynamicAABBTree::FreeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    nodes[node].body = nullptr;
+    freeList = node;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+    if (root == nullNode) {
+        root = leaf;
+        nodes[root].parent = nullNode;
+        return;
+    }
+
+    // Discesa guidata dal costo (perimetro) per trovare il fratello migliore
+    Bounds leafBounds = nodes[leaf].fat;
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = Perimeter(nodes[index].fat);
+        float combinedArea = Perimeter(Union(nodes[index].fat, leafBounds));
+
+        // Costo di creare un nuovo genitore per questo nodo e la foglia
+        float cost = 2.0f * combinedArea;
+        // Costo minimo di spingere la foglia piu in basso
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            float unionArea = Perimeter(Union(leafBounds, nodes[child].fat));
+            if (nodes[child].IsLeaf())
+                return unionArea + inheritanceCost;
+            return unionArea - Perimeter(nodes[child].fat) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();  // Puo riallocare nodes: solo indici da qui in poi
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].fat = Union(leafBounds, nodes[sibling].fat);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != nullNode) {
+        if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+    }
+    else {
+        root = newParent;
+    }
+
+    // Risali sistemando altezze e AABB, ruotando dove serve
+    index = nodes[leaf].parent;
+    while (index != nullNode) {
+        index = Balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].fat = Union(nodes[child1].fat, nodes[child2].fat);
+
+        index = nodes[index].parent;
+    }
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = nullNode;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == nullNode) {
+        root = sibling;
+        nodes[sibling].parent = nullNode;
+        FreeNode(parent);
+        return;
+    }
+
+    // Il fratello prende il posto del genitore
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    int index = grandParent;
+    while (index != nullNode) {
+        index = Balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].fat = Union(nodes[child1].fat, nodes[child2].fat);
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+
+        index = nodes[index].parent;
+    }
+}
+
+int DynamicAABBTree::Balance(int iA)
+{
+    Node &A = nodes[iA];
+    if (A.IsLeaf() || A.height < 2)
+        return iA;
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node &B = nodes[iB];
+    Node &C = nodes[iC];
+
+    int balance = C.height - B.height;
+
+    // Ruota C verso l'alto
+    if (balance > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node &F = nodes[iF];
+        Node &G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent != nullNode) {
+            if (nodes[C.parent].child1 == iA)
+                nodes[C.parent].child1 = iC;
+            else
+                nodes[C.parent].child2 = iC;
+        }
+        else {
+            root = iC;
+        }
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.fat = Union(B.fat, G.fat);
+            C.fat = Union(A.fat, F.fat);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.fat = Union(B.fat, F.fat);
+            C.fat = Union(A.fat, G.fat);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+
+        return iC;
+    }
+
+    // Ruota B verso l'alto
+    if (balance < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node &D = nodes[iD];
+        Node &E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent != nullNode) {
+            if (nodes[B.parent].child1 == iA)
+                nodes[B.parent].child1 = iB;
+            else
+                nodes[B.parent].child2 = iB;
+        }
+        else {
+            root = iB;
+        }
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.fat = Union(C.fat, E.fat);
+            B.fat = Union(A.fat, D.fat);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.fat = Union(C.fat, D.fat);
+            B.fat = Union(A.fat, E.fat);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+void DynamicAABBTree::Update(const std::vector<RigidBody *> &bodies)
+{
+    updateStamp++;
+    reinsertCount = 0;
+    moveBuffer.clear();
+    dyingProxies.clear();
+    newPairs.clear();
+    removedPairs.clear();
+
+    for (RigidBody *body : bodies) {
+        // Le coppie promesse sono quelle delle AABB allargate di margin: e questa
+        // che deve stare nella grassa, non quella stretta
+        AABB marginBox = GetBodyBounds(body, margin);
+        Bounds required = { marginBox.GetMinX(), marginBox.GetMinY(), marginBox.GetMaxX(), marginBox.GetMaxY() };
+
+        auto it = proxyOf.find(body);
+        if (it == proxyOf.end()) {
+            int proxy = AllocateNode();
+            nodes[proxy].body = body;
+            nodes[proxy].fat = MakeFatBounds(body);
+            nodes[proxy].stamp = updateStamp;
+            nodes[proxy].moved = true;
+            InsertLeaf(proxy);
+            proxyOf[body] = proxy;
+            moveBuffer.push_back(proxy);
+            continue;
+        }
+
+        int proxy = it->second;
+        nodes[proxy].stamp = updateStamp;
+
+        // Ancora dentro l'AABB grassa: l'albero non cambia
+        if (Contains(nodes[proxy].fat, required))
+            continue;
+
+        RemoveLeaf(proxy);
+        nodes[proxy].fat = MakeFatBounds(body);
+        nodes[proxy].moved = true;
+        InsertLeaf(proxy);
+        moveBuffer.push_back(proxy);
+        reinsertCount++;
+    }
+
+    // Corpi spariti dal mondo
+    if (proxyOf.size() != bodies.size()) {
+        for (auto it = proxyOf.begin(); it != proxyOf.end();) {
+            if (nodes[it->second].stamp == updateStamp) {
+                ++it;
+                continue;
+            }
+            nodes[it->second].dying = true;
+            dyingProxies.push_back(it->second);
+            it = proxyOf.erase(it);
+        }
+    }
+
+    if (trackPairs)
+        UpdatePairs();
+
+    for (int proxy : dyingProxies) {
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+    }
+    for (int proxy : moveBuffer)
+        nodes[proxy].moved = false;
+}
+
+BroadphasePair DynamicAABBTree::MakePair(int proxyA, int proxyB) const
+{
+    RigidBody *a = nodes[proxyA].body;
+    RigidBody *b = nodes[proxyB].body;
+    if (a < b)
+        return { a, b };
+    return { b, a };
+}
+
+void DynamicAABBTree::UpdatePairs()
+{
+    // Coppie rimosse: solo quelle con un proxy reinserito o distrutto possono cambiare
+    for (size_t i = 0; i < overlapPairs.size();) {
+        const Node &a = nodes[overlapPairs[i].proxyA];
+        const Node &b = nodes[overlapPairs[i].proxyB];
+
+        bool stale = a.dying || b.dying || ((a.moved || b.moved) && !Overlaps(a.fat, b.fat));
+        if (!stale) {
+            i++;
+            continue;
+        }
+
+        removedPairs.push_back(MakePair(overlapPairs[i].proxyA, overlapPairs[i].proxyB));
+        pairKeys.erase(PairKey(overlapPairs[i].proxyA, overlapPairs[i].proxyB));
+        overlapPairs[i] = overlapPairs.back();
+        overlapPairs.pop_back();
+    }
+
+    // Coppie nuove: interroga l'albero con le AABB dei proxy reinseriti
+    for (int proxy : moveBuffer) {
+        const Bounds &query = nodes[proxy].fat;
+
+        stack.clear();
+        if (root != nullNode)
+            stack.push_back(root);
+
+        while (!stack.empty()) {
+            int index = stack.back();
+            stack.pop_back();
+
+            const Node &node = nodes[index];
+            if (!Overlaps(node.fat, query))
+                continue;
+
+            if (!node.IsLeaf()) {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+                continue;
+            }
+
+            if (index == proxy || node.dying)
+                continue;
+
+            if (!pairKeys.insert(PairKey(proxy, index)).second)
+                continue;  // Gia presente (es. entrambi i proxy si sono mossi)
+
+            overlapPairs.push_back({ proxy, index });
+            newPairs.push_back(MakePair(proxy, index));
+        }
+    }
+}
+
+void DynamicAABBTree::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+    for (const auto &pair : overlapPairs)
+        pairs.push_back(MakePair(pair.proxyA, pair.proxyB));
+}
+
+void DynamicAABBTree::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    Bounds query = { range.GetMinX(), range.GetMinY(), range.GetMaxX(), range.GetMaxY() };
+
+    stack.clear();
+    if (root != nullNode)
+        stack.push_back(root);
+
+    while (!stack.empty()) {
+        int index = stack.back();
+        stack.pop_back();
+
+        const Node &node = nodes[index];
+        if (!Overlaps(node.fat, query))
+            continue;
+
+        if (!node.IsLeaf()) {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+            continue;
+        }
+
+        // Le AABB grasse sono solo un filtro: il test vero e sui bounds attuali
+        if (node.dying)
+            continue;
+        AABB bounds = GetBodyBounds(node.body, margin);
+        if (range.Intersects(bounds))
+            found.push_back(node.body);
+    }
+}
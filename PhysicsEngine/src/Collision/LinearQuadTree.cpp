@@ -0,0 +1,212 @@
+#include "Collision/LinearQuadTree.h"
+#include <algorithm>
+
+LinearQuadTree::LinearQuadTree(uint32_t leafCapacity, float margin)
+    : Broadphase(margin), leafCapacity(leafCapacity)
+{
+}
+
+uint32_t LinearQuadTree::SpreadBits(uint32_t v)
+{
+    // 16 bit -> posizioni pari di 32 bit
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+void LinearQuadTree::Update(const std::vector<RigidBody *> &bodies)
+{
+    boxes.clear();
+    nodes.clear();  // Mantiene la capacita: l'arena viene riusata
+
+    if (bodies.empty()) {
+        sorted.clear();
+        return;
+    }
+
+    // Bounds dei centri: il quadtree si adatta al mondo a ogni build
+    float minX = bodies[0]->position.x, maxX = minX;
+    float minY = bodies[0]->position.y, maxY = minY;
+    for (RigidBody *body : bodies) {
+        AABB bounds = GetBodyBounds(body, margin);
+        boxes.push_back({ body, bounds.GetMinX(), bounds.GetMinY(), bounds.GetMaxX(), bounds.GetMaxY() });
+        minX = std::min(minX, body->position.x);
+        maxX = std::max(maxX, body->position.x);
+        minY = std::min(minY, body->position.y);
+        maxY = std::max(maxY, body->position.y);
+    }
+
+    float extent = std::max(maxX - minX, maxY - minY);
+    float scale = extent > 1e-6f ? 65535.0f / extent : 0.0f;
+
+    items.resize(boxes.size());
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        const RigidBody *body = boxes[i].body;
+        uint32_t qx = static_cast<uint32_t>((body->position.x - minX) * scale);
+        uint32_t qy = static_cast<uint32_t>((body->position.y - minY) * scale);
+        qx = std::min(qx, 65535u);
+        qy = std::min(qy, 65535u);
+        items[i] = { SpreadBits(qx) | (SpreadBits(qy) << 1), i };
+    }
+
+    RadixSort();
+
+    sorted.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++)
+        sorted[i] = boxes[items[i].body];
+
+    BuildNodes();
+}
+
+void LinearQuadTree::RadixSort()
+{
+    // LSD radix sort, 4 passate da 8 bit (stabile, O(n))
+    scratch.resize(items.size());
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t count[257] = {};
+        for (const auto &item : items)
+            count[((item.code >> shift) & 0xFF) + 1]++;
+        for (int i = 0; i < 256; i++)
+            count[i + 1] += count[i];
+        for (const auto &item : items)
+            scratch[count[(item.code >> shift) & 0xFF]++] = item;
+        items.swap(scratch);
+    }
+}
+
+void LinearQuadTree::BuildNodes()
+{
+    nodes.push_back({ 0, 0, 0, 0, 0, static_cast<uint32_t>(sorted.size()), -1, 0, 0 });
+
+    // Passata lineare sull'array dei nodi: i figli vengono aggiunti in coda
+    // e processati dopo il padre (ordine in ampiezza)
+    for (size_t n = 0; n < nodes.size(); n++) {
+        Node node = nodes[n];
+        if (node.end - node.begin <= leafCapacity || node.level >= maxLevel)
+            continue;
+
+        // I codici sono ordinati: i 4 quadranti sono intervalli contigui
+        uint32_t shift = 30 - 2 * node.level;
+        uint32_t begin = node.begin;
+        int32_t firstChild = static_cast<int32_t>(nodes.size());
+        uint32_t childCount = 0;
+
+        while (begin < node.end) {
+            uint32_t quadrant = (items[begin].code >> shift) & 3;
+            uint32_t end = begin + 1;
+            while (end < node.end && ((items[end].code >> shift) & 3) == quadrant)
+                end++;
+
+            nodes.push_back({ 0, 0, 0, 0, begin, end, -1, 0, node.level + 1 });
+            childCount++;
+            begin = end;
+        }
+
+        nodes[n].firstChild = firstChild;
+        nodes[n].childCount = childCount;
+    }
+
+    // Bounds dal basso: i figli stanno sempre dopo il padre
+    for (size_t n = nodes.size(); n-- > 0;) {
+        Node &node = nodes[n];
+        if (node.firstChild < 0) {
+            const Box &first = sorted[node.begin];
+            node.minX = first.minX; node.minY = first.minY;
+            node.maxX = first.maxX; node.maxY = first.maxY;
+            for (uint32_t i = node.begin + 1; i < node.end; i++) {
+                node.minX = std::min(node.minX, sorted[i].minX);
+                node.minY = std::min(node.minY, sorted[i].minY);
+                node.maxX = std::max(node.maxX, sorted[i].maxX);
+                node.maxY = std::max(node.maxY, sorted[i].maxY);
+            }
+        }
+        else {
+            const Node &first = nodes[node.firstChild];
+            node.minX = first.minX; node.minY = first.minY;
+            node.maxX = first.maxX; node.maxY = first.maxY;
+            for (uint32_t c = 1; c < node.childCount; c++) {
+                const Node &child = nodes[node.firstChild + c];
+                node.minX = std::min(node.minX, child.minX);
+                node.minY = std::min(node.minY, child.minY);
+                node.maxX = std::max(node.maxX, child.maxX);
+                node.maxY = std::max(node.maxY, child.maxY);
+            }
+        }
+    }
+}
+
+void LinearQuadTree::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+    if (sorted.empty())
+        return;
+
+    // Profondita massima 16, al massimo 3 fratelli in attesa per livello
+    int32_t stack[4 * maxLevel + 4];
+
+    for (uint32_t i = 0; i < sorted.size(); i++) {
+        const Box &a = sorted[i];
+
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+
+            // Solo corpi dopo i nell'ordine: ogni coppia una volta sola
+            if (node.end <= i + 1)
+                continue;
+            if (!(a.minX < node.maxX && node.minX < a.maxX && a.minY < node.maxY && node.minY < a.maxY))
+                continue;
+
+            if (node.firstChild >= 0) {
+                for (uint32_t c = 0; c < node.childCount; c++)
+                    stack[top++] = node.firstChild + c;
+                continue;
+            }
+
+            for (uint32_t j = std::max(node.begin, i + 1); j < node.end; j++) {
+                const Box &b = sorted[j];
+                if (a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY) {
+                    if (a.body < b.body)
+                        pairs.push_back({ a.body, b.body });
+                    else
+                        pairs.push_back({ b.body, a.body });
+                }
+            }
+        }
+    }
+}
+
+void LinearQuadTree::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    if (sorted.empty())
+        return;
+
+    float minX = range.GetMinX(), maxX = range.GetMaxX();
+    float minY = range.GetMinY(), maxY = range.GetMaxY();
+
+    int32_t stack[4 * maxLevel + 4];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node &node = nodes[stack[--top]];
+        if (!(minX < node.maxX && node.minX < maxX && minY < node.maxY && node.minY < maxY))
+            continue;
+
+        if (node.firstChild >= 0) {
+            for (uint32_t c = 0; c < node.childCount; c++)
+                stack[top++] = node.firstChild + c;
+            continue;
+        }
+
+        for (uint32_t j = node.begin; j < node.end; j++) {
+            const Box &b = sorted[j];
+            if (minX < b.maxX && b.minX < maxX && minY < b.maxY && b.minY < maxY)
+                found.push_back(b.body);
+        }
+    }
+}
@@ -0,0 +1,372 @@
+#include "Collision/LooseQuadTree.h"
+#include <algorithm>
+#include <cmath>
+
+LooseQuadTree::LooseQuadTree(float margin)
+    : Broadphase(margin), freeNodes(nullIndex), root(nullIndex), updateStamp(0), relocationCount(0)
+{
+}
+
+int32_t LooseQuadTree::AllocateNode(float centerX, float centerY, float half, int32_t parent)
+{
+    int32_t id;
+    if (freeNodes != nullIndex) {
+        id = freeNodes;
+        freeNodes = nodes[id].parent;
+    }
+    else {
+        id = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node &node = nodes[id];
+    node.centerX = centerX;
+    node.centerY = centerY;
+    node.half = half;
+    node.parent = parent;
+    node.firstProxy = nullIndex;
+    for (int32_t &child : node.children)
+        child = nullIndex;
+    return id;
+}
+
+void LooseQuadTree::FreeNode(int32_t node)
+{
+    nodes[node].parent = freeNodes;
+    freeNodes = node;
+}
+
+bool LooseQuadTree::Fits(const Node &node, const Proxy &proxy) const
+{
+    // Centro nella cella stretta e dimensione entro il semi-lato:
+    // allora il corpo sta tutto nei bounds allargati del nodo
+    float cx = (proxy.minX + proxy.maxX) * 0.5f;
+    float cy = (proxy.minY + proxy.maxY) * 0.5f;
+    float extent = std::max(proxy.maxX - proxy.minX, proxy.maxY - proxy.minY) * 0.5f;
+
+    return extent <= node.half &&
+        cx >= node.centerX - node.half && cx < node.centerX + node.half &&
+        cy >= node.centerY - node.half && cy < node.centerY + node.half;
+}
+
+void LooseQuadTree::GrowToFit(const Proxy &proxy)
+{
+    float cx = (proxy.minX + proxy.maxX) * 0.5f;
+    float cy = (proxy.minY + proxy.maxY) * 0.5f;
+
+    if (root == nullIndex) {
+        float extent = std::max(proxy.maxX - proxy.minX, proxy.maxY - proxy.minY) * 0.5f;
+        root = AllocateNode(cx, cy, std::max(1.0f, extent * 2.0f), nullIndex);
+        return;
+    }
+
+    // Raddoppia la radice verso il corpo: la vecchia diventa un quadrante.
+    // Il limite protegge da coordinate non finite.
+    for (int growth = 0; growth < 64 && !Fits(nodes[root], proxy); growth++) {
+        const Node old = nodes[root];
+        float newX = cx < old.centerX ? old.centerX - old.half : old.centerX + old.half;
+        float newY = cy < old.centerY ? old.centerY - old.half : old.centerY + old.half;
+
+        int32_t newRoot = AllocateNode(newX, newY, old.half * 2.0f, nullIndex);
+        int quadrant = (old.centerX >= newX ? 1 : 0) | (old.centerY >= newY ? 2 : 0);
+        nodes[newRoot].children[quadrant] = root;
+        nodes[root].parent = newRoot;
+        root = newRoot;
+    }
+}
+
+void LooseQuadTree::ShrinkRoot()
+{
+    // Radice senza corpi e con un solo figlio: il figlio diventa la radice
+    while (root != nullIndex && nodes[root].firstProxy == nullIndex) {
+        int32_t only = nullIndex;
+        int count = 0;
+        for (int32_t child : nodes[root].children) {
+            if (child != nullIndex) {
+                only = child;
+                count++;
+            }
+        }
+        if (count != 1)
+            return;
+
+        FreeNode(root);
+        root = only;
+        nodes[root].parent = nullIndex;
+    }
+}
+
+void LooseQuadTree::InsertProxy(uint32_t id)
+{
+    GrowToFit(proxies[id]);
+
+    const Proxy &proxy = proxies[id];
+    float cx = (proxy.minX + proxy.maxX) * 0.5f;
+    float cy = (proxy.minY + proxy.maxY) * 0.5f;
+    float extent = std::max(proxy.maxX - proxy.minX, proxy.maxY - proxy.minY) * 0.5f;
+
+    // Scendi finche il corpo entra nella meta del figlio
+    int32_t index = root;
+    for (int depth = 0; depth < maxDepth && extent <= nodes[index].half * 0.5f; depth++) {
+        const Node &node = nodes[index];
+        int quadrant = (cx >= node.centerX ? 1 : 0) | (cy >= node.centerY ? 2 : 0);
+
+        int32_t child = node.children[quadrant];
+        if (child == nullIndex) {
+            float quarter = node.half * 0.5f;
+            float childX = node.centerX + ((quadrant & 1) ? quarter : -quarter);
+            float childY = node.centerY + ((quadrant & 2) ? quarter : -quarter);
+            child = AllocateNode(childX, childY, quarter, index);  // Puo riallocare nodes
+            nodes[index].children[quadrant] = child;
+        }
+        index = child;
+    }
+
+    Proxy &p = proxies[id];
+    p.node = index;
+    p.prev = nullIndex;
+    p.next = nodes[index].firstProxy;
+    if (p.next != nullIndex)
+        proxies[p.next].prev = static_cast<int32_t>(id);
+    nodes[index].firstProxy = static_cast<int32_t>(id);
+}
+
+void LooseQuadTree::RemoveProxy(uint32_t id)
+{
+    Proxy &proxy = proxies[id];
+    if (proxy.prev != nullIndex)
+        proxies[proxy.prev].next = proxy.next;
+    else
+        nodes[proxy.node].firstProxy = proxy.next;
+    if (proxy.next != nullIndex)
+        proxies[proxy.next].prev = proxy.prev;
+
+    int32_t node = proxy.node;
+    proxy.node = nullIndex;
+    PruneEmpty(node);
+}
+
+void LooseQuadTree::PruneEmpty(int32_t index)
+{
+    // Risali liberando i nodi rimasti senza corpi e senza figli
+    while (index != nullIndex && index != root) {
+        const Node &node = nodes[index];
+        if (node.firstProxy != nullIndex)
+            return;
+        for (int32_t child : node.children) {
+            if (child != nullIndex)
+                return;
+        }
+
+        int32_t parent = node.parent;
+        for (int32_t &child : nodes[parent].children) {
+            if (child == index)
+                child = nullIndex;
+        }
+        FreeNode(index);
+        index = parent;
+    }
+}
+
+void LooseQuadTree::Update(const std::vector<RigidBody *> &bodies)
+{
+    updateStamp++;
+    relocationCount = 0;
+
+    for (RigidBody *body : bodies) {
+        AABB bounds = GetBodyBounds(body, margin);
+
+        uint32_t id;
+        bool isNew = false;
+        auto it = proxyOf.find(body);
+        if (it == proxyOf.end()) {
+            if (!freeProxies.empty()) {
+                id = freeProxies.back();
+                freeProxies.pop_back();
+            }
+            else {
+                id = static_cast<uint32_t>(proxies.size());
+                proxies.emplace_back();
+            }
+            proxyOf[body] = id;
+            proxies[id].body = body;
+            isNew = true;
+        }
+        else {
+            id = it->second;
+        }
+
+        Proxy &proxy = proxies[id];
+        proxy.minX = bounds.GetMinX();
+        proxy.minY = bounds.GetMinY();
+        proxy.maxX = bounds.GetMaxX();
+        proxy.maxY = bounds.GetMaxY();
+        proxy.stamp = updateStamp;
+
+        if (isNew) {
+            InsertProxy(id);
+            continue;
+        }
+
+        // Ancora dentro il suo nodo: niente da fare
+        if (Fits(nodes[proxy.node], proxy))
+            continue;
+
+        RemoveProxy(id);
+        InsertProxy(id);
+        relocationCount++;
+    }
+
+    // Corpi spariti dal mondo
+    if (proxyOf.size() != bodies.size()) {
+        for (auto it = proxyOf.begin(); it != proxyOf.end();) {
+            if (proxies[it->second].stamp == updateStamp) {
+                ++it;
+                continue;
+            }
+            RemoveProxy(it->second);
+            proxies[it->second].body = nullptr;
+            freeProxies.push_back(it->second);
+            it = proxyOf.erase(it);
+        }
+    }
+
+    ShrinkRoot();
+}
+
+template <typename Proxy>
+static inline bool ProxiesOverlap(const Proxy &a, const Proxy &b)
+{
+    return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY;
+}
+
+static inline void AddPair(RigidBody *a, RigidBody *b, std::vector<BroadphasePair> &pairs)
+{
+    if (a < b)
+        pairs.push_back({ a, b });
+    else
+        pairs.push_back({ b, a });
+}
+
+bool LooseQuadTree::LooseOverlap(const Node &a, const Node &b) const
+{
+    // Bounds allargati: il doppio della cella stretta
+    float reach = (a.half + b.half) * 2.0f;
+    return std::abs(a.centerX - b.centerX) < reach && std::abs(a.centerY - b.centerY) < reach;
+}
+
+void LooseQuadTree::ProxyVsSubtree(const Proxy &proxy, int32_t index, std::vector<BroadphasePair> &pairs) const
+{
+    const Node &node = nodes[index];
+    float loose = node.half * 2.0f;
+    if (proxy.maxX <= node.centerX - loose || node.centerX + loose <= proxy.minX ||
+        proxy.maxY <= node.centerY - loose || node.centerY + loose <= proxy.minY)
+        return;
+
+    for (int32_t q = node.firstProxy; q != nullIndex; q = proxies[q].next) {
+        if (ProxiesOverlap(proxy, proxies[q]))
+            AddPair(proxy.body, proxies[q].body, pairs);
+    }
+
+    for (int32_t child : node.children) {
+        if (child != nullIndex)
+            ProxyVsSubtree(proxy, child, pairs);
+    }
+}
+
+void LooseQuadTree::PairsBetween(int32_t a, int32_t b, std::vector<BroadphasePair> &pairs) const
+{
+    // Coppie tra due sottoalberi disgiunti
+    const Node &nodeA = nodes[a];
+    const Node &nodeB = nodes[b];
+    if (!LooseOverlap(nodeA, nodeB))
+        return;
+
+    for (int32_t p = nodeA.firstProxy; p != nullIndex; p = proxies[p].next) {
+        for (int32_t q = nodeB.firstProxy; q != nullIndex; q = proxies[q].next) {
+            if (ProxiesOverlap(proxies[p], proxies[q]))
+                AddPair(proxies[p].body, proxies[q].body, pairs);
+        }
+        for (int32_t child : nodeB.children) {
+            if (child != nullIndex)
+                ProxyVsSubtree(proxies[p], child, pairs);
+        }
+    }
+
+    for (int32_t q = nodeB.firstProxy; q != nullIndex; q = proxies[q].next) {
+        for (int32_t child : nodeA.children) {
+            if (child != nullIndex)
+                ProxyVsSubtree(proxies[q], child, pairs);
+        }
+    }
+
+    for (int32_t childA : nodeA.children) {
+        if (childA == nullIndex)
+            continue;
+        for (int32_t childB : nodeB.children) {
+            if (childB != nullIndex)
+                PairsBetween(childA, childB, pairs);
+        }
+    }
+}
+
+void LooseQuadTree::PairsWithin(int32_t index, std::vector<BroadphasePair> &pairs) const
+{
+    // Coppie dentro il sottoalbero: nel nodo stesso, nodo contro discendenti,
+    // e tra sottoalberi fratelli. Ogni coppia viene trovata una sola volta.
+    const Node &node = nodes[index];
+
+    for (int32_t p = node.firstProxy; p != nullIndex; p = proxies[p].next) {
+        for (int32_t q = proxies[p].next; q != nullIndex; q = proxies[q].next) {
+            if (ProxiesOverlap(proxies[p], proxies[q]))
+                AddPair(proxies[p].body, proxies[q].body, pairs);
+        }
+        for (int32_t child : node.children) {
+            if (child != nullIndex)
+                ProxyVsSubtree(proxies[p], child, pairs);
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (node.children[i] == nullIndex)
+            continue;
+        for (int j = i + 1; j < 4; j++) {
+            if (node.children[j] != nullIndex)
+                PairsBetween(node.children[i], node.children[j], pairs);
+        }
+        PairsWithin(node.children[i], pairs);
+    }
+}
+
+void LooseQuadTree::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+    if (root != nullIndex)
+        PairsWithin(root, pairs);
+}
+
+void LooseQuadTree::QuerySubtree(int32_t index, float minX, float minY, float maxX, float maxY, std::vector<RigidBody *> &found) const
+{
+    const Node &node = nodes[index];
+    float loose = node.half * 2.0f;
+    if (maxX <= node.centerX - loose || node.centerX + loose <= minX ||
+        maxY <= node.centerY - loose || node.centerY + loose <= minY)
+        return;
+
+    for (int32_t p = node.firstProxy; p != nullIndex; p = proxies[p].next) {
+        const Proxy &proxy = proxies[p];
+        if (minX < proxy.maxX && proxy.minX < maxX && minY < proxy.maxY && proxy.minY < maxY)
+            found.push_back(proxy.body);
+    }
+
+    for (int32_t child : node.children) {
+        if (child != nullIndex)
+            QuerySubtree(child, minX, minY, maxX, maxY, found);
+    }
+}
+
+void LooseQuadTree::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    if (root != nullIndex)
+        QuerySubtree(root, range.GetMinX(), range.GetMinY(), range.GetMaxX(), range.GetMaxY(), found);
+}
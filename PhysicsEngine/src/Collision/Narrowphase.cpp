@@ -0,0 +1,55 @@
+#include "Collision/Narrowphase.h"
+#include <array>
+#include <utility>
+
+using DetectFunction = bool (*)(RigidBody *, RigidBody *, CollisionInfo &);
+
+template <int I>
+static bool DetectBucket(RigidBody *a, RigidBody *b, CollisionInfo &info)
+{
+    constexpr ShapeType A = static_cast<ShapeType>(I / ShapeTypeCount);
+    constexpr ShapeType B = static_cast<ShapeType>(I % ShapeTypeCount);
+    if constexpr (A <= B)
+        return ContactKernel<A, B>::Detect(a, b, info);
+    else
+        return false;  // Mai nei bucket: le coppie arrivano scambiate
+}
+
+template <int... I>
+static constexpr std::array<DetectFunction, sizeof...(I)> MakeDetectTable(std::integer_sequence<int, I...>)
+{
+    return { &DetectBucket<I>... };
+}
+
+static constexpr auto detectTable = MakeDetectTable(std::make_integer_sequence<int, ShapeTypeCount * ShapeTypeCount>());
+
+bool PairBuckets::Detect(const BroadphasePair &pair, CollisionInfo &info)
+{
+    return detectTable[Index(pair.bodyA->shapeType, pair.bodyB->shapeType)](pair.bodyA, pair.bodyB, info);
+}
+
+void PairBuckets::Clear()
+{
+    for (auto &bucket : buckets)
+        bucket.clear();
+}
+
+void PairBuckets::Build(const std::vector<BroadphasePair> &pairs)
+{
+    Clear();
+
+    for (const auto &pair : pairs) {
+        if (pair.bodyA->shapeType <= pair.bodyB->shapeType)
+            buckets[Index(pair.bodyA->shapeType, pair.bodyB->shapeType)].push_back(pair);
+        else
+            buckets[Index(pair.bodyB->shapeType, pair.bodyA->shapeType)].push_back({ pair.bodyB, pair.bodyA });
+    }
+}
+
+size_t PairBuckets::Size() const
+{
+    size_t total = 0;
+    for (const auto &bucket : buckets)
+        total += bucket.size();
+    return total;
+}
@@ -1,12 +1,16 @@
 #include "Collision/QuadTree.h"
+#include <algorithm>
 
-QuadTree::QuadTree(const AABB &boundary, int capacity)
-    : boundary(boundary), capacity(capacity), divided(false)
+QuadTree::QuadTree(const AABB &boundary, int capacity, QuadTree *parent)
+    : boundary(boundary), capacity(capacity), parent(parent), root(parent ? parent->root : this), divided(false),
+    persistent(false), updateStamp(0), relocationCount(0)
 {
 }
 
 void QuadTree::Clear() {
     objects.clear();
+    leafOf.clear();
+    persistent = false;
 
     if (divided) {
         northWest.reset();
@@ -24,6 +28,8 @@ bool QuadTree::Insert(RigidBody *body)
 
     if (objects.size() < capacity && !divided) {
         objects.push_back(body);
+        if (root->persistent)
+            root->leafOf[body] = { this, root->updateStamp };
         return true;
     }
 
@@ -32,7 +38,8 @@ bool QuadTree::Insert(RigidBody *body)
 
         // Redistribuisci oggetti esistenti nei figli
         for (auto *obj : objects) {
-            InsertIntoChildren(obj);
+            if (!InsertIntoChildren(obj) && root->persistent)
+                root->leafOf.erase(obj);
         }
 
         // Svuota questo nodo (ora gli oggetti sono nei figli)
@@ -42,22 +49,9 @@ bool QuadTree::Insert(RigidBody *body)
     return InsertIntoChildren(body);
 }
 
-void QuadTree::Query(const AABB &range, std::set<RigidBody *> &found)
+void QuadTree::Query(const AABB &range, std::vector<RigidBody *> &found) const
 {
-    if (!boundary.Intersects(range))
-        return;
-
-    for (auto obj : objects) {
-        if (range.Contains(obj->position))
-            found.insert(obj);
-    }
-
-    if (divided) {
-        northWest->Query(range, found);
-        northEast->Query(range, found);
-        southWest->Query(range, found);
-        southEast->Query(range, found);
-    }
+    Visit(range, [&found](RigidBody *obj) { found.push_back(obj); });
 }
 
 void QuadTree::Subdivide()
@@ -71,10 +65,10 @@ void QuadTree::Subdivide()
     float quaterWidth = boundary.halfWidth / 2;
     float quaterHeight = boundary.halfHeight / 2;
 
-    northWest = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x - quaterWidth, boundary.center.y + quaterHeight), quaterWidth, quaterHeight), capacity);
-    northEast = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x + quaterWidth, boundary.center.y + quaterHeight), quaterWidth, quaterHeight), capacity);
-    southWest = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x - quaterWidth, boundary.center.y - quaterHeight), quaterWidth, quaterHeight), capacity);
-    southEast = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x + quaterWidth, boundary.center.y - quaterHeight), quaterWidth, quaterHeight), capacity);
+    northWest = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x - quaterWidth, boundary.center.y + quaterHeight), quaterWidth, quaterHeight), capacity, this);
+    northEast = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x + quaterWidth, boundary.center.y + quaterHeight), quaterWidth, quaterHeight), capacity, this);
+    southWest = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x - quaterWidth, boundary.center.y - quaterHeight), quaterWidth, quaterHeight), capacity, this);
+    southEast = std::make_unique<QuadTree>(AABB(Vector2(boundary.center.x + quaterWidth, boundary.center.y - quaterHeight), quaterWidth, quaterHeight), capacity, this);
 
     divided = true;
 }
@@ -89,16 +83,124 @@ bool QuadTree::InsertIntoChildren(RigidBody *body)
 
     AABB bodyBounds(body->position, halfW, halfH);
 
-    // Inserisci in TUTTI i quadranti che interseca
-    bool inserted = false;
-    if (northWest->boundary.Intersects(bodyBounds))
-        inserted |= northWest->Insert(body);
-    if (northEast->boundary.Intersects(bodyBounds))
-        inserted |= northEast->Insert(body);
-    if (southWest->boundary.Intersects(bodyBounds))
-        inserted |= southWest->Insert(body);
-    if (southEast->boundary.Intersects(bodyBounds))
-        inserted |= southEast->Insert(body);
-
-    return inserted;
+    // Insert accetta solo il quadrante che contiene il centro: ci fermiamo al primo,
+    // cosi un centro sul bordo tra due quadranti non viene salvato due volte
+    if (northWest->boundary.Intersects(bodyBounds) && northWest->Insert(body))
+        return true;
+    if (northEast->boundary.Intersects(bodyBounds) && northEast->Insert(body))
+        return true;
+    if (southWest->boundary.Intersects(bodyBounds) && southWest->Insert(body))
+        return true;
+    if (southEast->boundary.Intersects(bodyBounds) && southEast->Insert(body))
+        return true;
+
+    return false;
+}
+
+void QuadTree::Update(const std::vector<RigidBody *> &bodies)
+{
+    // Primo Update persistente: si riparte da un albero vuoto
+    if (!persistent) {
+        Clear();
+        persistent = true;
+    }
+
+    updateStamp++;
+    relocationCount = 0;
+
+    // Prima i corpi rimossi dal mondo dall'ultimo Update: sono gia liberati,
+    // e una Subdivide durante gli inserimenti leggerebbe la loro posizione
+    size_t tracked = 0;
+    for (RigidBody *body : bodies) {
+        auto it = leafOf.find(body);
+        if (it != leafOf.end()) {
+            it->second.stamp = updateStamp;
+            tracked++;
+        }
+    }
+    if (leafOf.size() != tracked) {
+        for (auto it = leafOf.begin(); it != leafOf.end();) {
+            if (it->second.stamp == updateStamp) {
+                ++it;
+                continue;
+            }
+            QuadTree *leaf = it->second.leaf;
+            leaf->RemoveObject(it->first);
+            it = leafOf.erase(it);
+            if (leaf->parent)
+                leaf->parent->TryMerge();
+        }
+    }
+
+    for (RigidBody *body : bodies) {
+
+        auto it = leafOf.find(body);
+        if (it == leafOf.end()) {
+            // Corpo nuovo (o rientrato nei bounds del mondo)
+            Insert(body);
+            continue;
+        }
+
+        QuadTree *leaf = it->second.leaf;
+        if (leaf->boundary.Contains(body->position))
+            continue;  // Ancora nella sua foglia: niente da fare
+
+        // Risali fino al primo antenato che contiene il corpo e reinserisci da li
+        leaf->RemoveObject(body);
+        QuadTree *node = leaf->parent;
+        while (node && !node->boundary.Contains(body->position))
+            node = node->parent;
+
+        if (!node || !node->Insert(body))
+            leafOf.erase(body);  // Uscito dal mondo: come nel rebuild, non collide piu
+        relocationCount++;
+
+        // Merge pigro della vecchia foglia
+        if (leaf->parent)
+            leaf->parent->TryMerge();
+    }
+}
+
+void QuadTree::RemoveObject(RigidBody *body)
+{
+    auto it = std::find(objects.begin(), objects.end(), body);
+    if (it != objects.end()) {
+        *it = objects.back();
+        objects.pop_back();
+    }
+}
+
+void QuadTree::TryMerge()
+{
+    if (!divided)
+        return;
+
+    QuadTree *children[4] = { northWest.get(), northEast.get(), southWest.get(), southEast.get() };
+
+    size_t total = 0;
+    for (QuadTree *child : children) {
+        if (child->divided)
+            return;
+        total += child->objects.size();
+    }
+
+    // Isteresi: si divide oltre capacity, si riunisce solo sotto capacity / 2
+    if (total > static_cast<size_t>(capacity / 2))
+        return;
+
+    for (QuadTree *child : children) {
+        for (auto *obj : child->objects) {
+            objects.push_back(obj);
+            root->leafOf[obj].leaf = this;
+        }
+    }
+
+    northWest.reset();
+    northEast.reset();
+    southWest.reset();
+    southEast.reset();
+    divided = false;
+
+    if (parent)
+        parent->TryMerge();
 }
\ No newline at end of file
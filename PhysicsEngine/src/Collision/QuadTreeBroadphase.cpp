@@ -0,0 +1,88 @@
+#include "Collision/QuadTreeBroadphase.h"
+#include <algorithm>
+
+QuadTreeBroadphase::QuadTreeBroadphase(const AABB &worldBounds, int capacity, float margin)
+    : Broadphase(margin), tree(worldBounds, capacity), worldBounds(worldBounds), persistent(false), maxHalfExtent(0.0f)
+{
+}
+
+void QuadTreeBroadphase::SetPersistent(bool enabled)
+{
+    persistent = enabled;
+    tree.Clear();  // Le due modalita non condividono lo stato dell'albero
+}
+
+void QuadTreeBroadphase::Update(const std::vector<RigidBody *> &bodies)
+{
+    if (persistent) {
+        tree.Update(bodies);
+    }
+    else {
+        tree.Clear();
+        for (RigidBody *body : bodies) {
+            tree.Insert(body);
+        }
+    }
+
+    // Dimensione massima nel mondo: una passata sola invece che una per corpo
+    inserted.clear();
+    outside.clear();
+    maxHalfExtent = 0.0f;
+    for (RigidBody *body : bodies) {
+        AABB bounds = GetBodyBounds(body);
+        maxHalfExtent = std::max(maxHalfExtent, std::max(bounds.halfWidth, bounds.halfHeight));
+        inserted.push_back(body);
+        if (!worldBounds.Contains(body->position))
+            outside.push_back(body);
+    }
+}
+
+void QuadTreeBroadphase::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+
+    for (RigidBody *body : inserted) {
+        if (!worldBounds.Contains(body->position))
+            continue;
+
+        // Il QuadTree indicizza i centri: basta allargare la query della
+        // semi-dimensione massima perche contenga ogni centro che puo sovrapporsi
+        AABB bounds = GetBodyBounds(body, margin);
+        AABB queryRange(body->position, bounds.halfWidth + maxHalfExtent + margin, bounds.halfHeight + maxHalfExtent + margin);
+
+        // Ogni corpo sta in una sola foglia: il visitor non vede duplicati
+        tree.Visit(queryRange, [&](RigidBody *other) {
+            if (body >= other) return;  // Evita coppie doppie e self-check
+
+            if (bounds.Intersects(GetBodyBounds(other, margin)))
+                pairs.push_back({ body, other });
+        });
+    }
+
+    // Fuori dall'albero: contro tutti, una volta sola per coppia di esterni
+    for (RigidBody *body : outside) {
+        AABB bounds = GetBodyBounds(body, margin);
+        for (RigidBody *other : inserted) {
+            if (other == body || (other < body && !worldBounds.Contains(other->position)))
+                continue;
+            if (bounds.Intersects(GetBodyBounds(other, margin)))
+                pairs.push_back({ std::min(body, other), std::max(body, other) });
+        }
+    }
+}
+
+void QuadTreeBroadphase::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    // Stesso allargamento di FindPairs: i centri utili distano al massimo
+    // la semi-dimensione del corpo piu grande
+    AABB queryRange(range.center, range.halfWidth + maxHalfExtent + margin, range.halfHeight + maxHalfExtent + margin);
+
+    tree.Visit(queryRange, [&](RigidBody *body) {
+        if (range.Intersects(GetBodyBounds(body, margin)))
+            found.push_back(body);
+    });
+    for (RigidBody *body : outside) {
+        if (range.Intersects(GetBodyBounds(body, margin)))
+            found.push_back(body);
+    }
+}
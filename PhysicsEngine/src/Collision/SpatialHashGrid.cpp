@@ -0,0 +1,228 @@
+#include "Collision/SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize, float margin)
+    : Broadphase(margin), generation(0), bucketMask(0), fixedCellSize(cellSize), cellSize(cellSize > 0.0f ? cellSize : 1.0f),
+    invCellSize(1.0f / this->cellSize)
+{
+}
+
+int32_t SpatialHashGrid::CellCoord(float value) const
+{
+    return static_cast<int32_t>(std::floor(value * invCellSize));
+}
+
+uint32_t SpatialHashGrid::HashCell(int32_t cellX, int32_t cellY) const
+{
+    uint32_t h = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellY) * 19349663u;
+    return h & bucketMask;
+}
+
+void SpatialHashGrid::ComputeCellSize()
+{
+    if (fixedCellSize > 0.0f || items.empty())
+        return;
+
+    // Mediana e non media: un pavimento enorme non deve gonfiare le celle
+    extents.clear();
+    for (const auto &item : items)
+        extents.push_back(std::max(item.maxX - item.minX, item.maxY - item.minY));
+
+    auto mid = extents.begin() + extents.size() / 2;
+    std::nth_element(extents.begin(), mid, extents.end());
+
+    if (*mid > 1e-4f) {
+        cellSize = *mid;
+        invCellSize = 1.0f / cellSize;
+    }
+}
+
+void SpatialHashGrid::EnsureBuckets(size_t entryCount)
+{
+    // Potenza di 2, almeno il doppio delle entry: poche collisioni di hash
+    size_t wanted = 64;
+    while (wanted < entryCount * 2)
+        wanted *= 2;
+
+    if (wanted > bucketGeneration.size()) {
+        // Le nuove generazioni partono da 0, sempre < generation: bucket vuoti
+        bucketStart.resize(wanted);
+        bucketCount.resize(wanted);
+        bucketGeneration.resize(wanted, 0);
+    }
+    bucketMask = static_cast<uint32_t>(bucketGeneration.size() - 1);
+}
+
+void SpatialHashGrid::Update(const std::vector<RigidBody *> &bodies)
+{
+    items.clear();
+    oversized.clear();
+    unsortedEntries.clear();
+    usedBuckets.clear();
+
+    for (RigidBody *body : bodies) {
+        AABB bounds = GetBodyBounds(body, margin);
+        items.push_back({ body, bounds.GetMinX(), bounds.GetMinY(), bounds.GetMaxX(), bounds.GetMaxY(), false });
+    }
+
+    ComputeCellSize();
+
+    // Prima passata: celle coperte da ogni corpo
+    for (uint32_t i = 0; i < items.size(); i++) {
+        Item &item = items[i];
+        int32_t x0 = CellCoord(item.minX), x1 = CellCoord(item.maxX);
+        int32_t y0 = CellCoord(item.minY), y1 = CellCoord(item.maxY);
+
+        if (static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > maxCellsPerBody) {
+            item.oversized = true;
+            oversized.push_back(i);
+            continue;
+        }
+
+        for (int32_t y = y0; y <= y1; y++) {
+            for (int32_t x = x0; x <= x1; x++) {
+                unsortedEntries.push_back({ i, 0, x, y });
+            }
+        }
+    }
+
+    EnsureBuckets(unsortedEntries.size());
+
+    // Nuova generazione: tutti i bucket tornano vuoti senza toccarli
+    generation++;
+    if (generation == 0) {
+        std::fill(bucketGeneration.begin(), bucketGeneration.end(), 0u);
+        generation = 1;
+    }
+
+    // Counting sort per bucket
+    for (auto &e : unsortedEntries) {
+        e.bucket = HashCell(e.cellX, e.cellY);
+        if (bucketGeneration[e.bucket] != generation) {
+            bucketGeneration[e.bucket] = generation;
+            bucketCount[e.bucket] = 0;
+            usedBuckets.push_back(e.bucket);
+        }
+        bucketCount[e.bucket]++;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t bucket : usedBuckets) {
+        bucketStart[bucket] = offset;
+        offset += bucketCount[bucket];
+        bucketCount[bucket] = 0;  // Riusato come cursore di riempimento
+    }
+
+    entries.resize(unsortedEntries.size());
+    for (const auto &e : unsortedEntries) {
+        entries[bucketStart[e.bucket] + bucketCount[e.bucket]++] = e;
+    }
+}
+
+void SpatialHashGrid::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+
+    auto overlaps = [](const Item &a, const Item &b) {
+        return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY;
+    };
+
+    auto emit = [&pairs](RigidBody *a, RigidBody *b) {
+        if (a < b)
+            pairs.push_back({ a, b });
+        else
+            pairs.push_back({ b, a });
+    };
+
+    for (uint32_t bucket : usedBuckets) {
+        const Entry *begin = entries.data() + bucketStart[bucket];
+        const Entry *end = begin + bucketCount[bucket];
+
+        for (const Entry *ea = begin; ea != end; ++ea) {
+            const Item &a = items[ea->item];
+            for (const Entry *eb = ea + 1; eb != end; ++eb) {
+                // Collisione di hash: celle diverse nello stesso bucket
+                if (ea->cellX != eb->cellX || ea->cellY != eb->cellY)
+                    continue;
+
+                const Item &b = items[eb->item];
+                if (!overlaps(a, b))
+                    continue;
+
+                // La coppia appartiene solo alla cella che contiene l'angolo minimo
+                // della loro intersezione: niente duplicati senza std::set
+                if (CellCoord(std::max(a.minX, b.minX)) != ea->cellX ||
+                    CellCoord(std::max(a.minY, b.minY)) != ea->cellY)
+                    continue;
+
+                emit(a.body, b.body);
+            }
+        }
+    }
+
+    // I corpi fuori scala si testano contro tutti gli altri
+    for (uint32_t i : oversized) {
+        const Item &big = items[i];
+        for (uint32_t j = 0; j < items.size(); j++) {
+            // Coppia tra due oversized: solo una volta
+            if (items[j].oversized && j <= i)
+                continue;
+            if (overlaps(big, items[j]))
+                emit(big.body, items[j].body);
+        }
+    }
+}
+
+void SpatialHashGrid::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    float minX = range.GetMinX(), maxX = range.GetMaxX();
+    float minY = range.GetMinY(), maxY = range.GetMaxY();
+
+    auto overlaps = [&](const Item &item) {
+        return minX < item.maxX && item.minX < maxX && minY < item.maxY && item.minY < maxY;
+    };
+
+    int32_t x0 = CellCoord(minX), x1 = CellCoord(maxX);
+    int32_t y0 = CellCoord(minY), y1 = CellCoord(maxY);
+
+    // Regione piu grande di tutta la griglia: conviene scorrere i corpi
+    if (bucketGeneration.empty() || static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > static_cast<int64_t>(items.size())) {
+        for (const auto &item : items) {
+            if (overlaps(item))
+                found.push_back(item.body);
+        }
+        return;
+    }
+
+    for (int32_t y = y0; y <= y1; y++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            uint32_t bucket = HashCell(x, y);
+            if (bucketGeneration[bucket] != generation)
+                continue;
+
+            const Entry *begin = entries.data() + bucketStart[bucket];
+            const Entry *end = begin + bucketCount[bucket];
+            for (const Entry *e = begin; e != end; ++e) {
+                if (e->cellX != x || e->cellY != y)
+                    continue;
+
+                const Item &item = items[e->item];
+                if (!overlaps(item))
+                    continue;
+
+                // Stesso criterio di FindPairs: il corpo si riporta solo nella
+                // cella dell'angolo minimo dell'intersezione con range
+                if (CellCoord(std::max(minX, item.minX)) != x || CellCoord(std::max(minY, item.minY)) != y)
+                    continue;
+
+                found.push_back(item.body);
+            }
+        }
+    }
+
+    for (uint32_t i : oversized) {
+        if (overlaps(items[i]))
+            found.push_back(items[i].body);
+    }
+}
@@ -0,0 +1,169 @@
+#include "Collision/SweepAndPrune.h"
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune(float margin)
+    : Broadphase(margin), updateStamp(0), swapCount(0), maxWidth(0.0f)
+{
+}
+
+bool SweepAndPrune::EndpointLess(const Endpoint &a, const Endpoint &b)
+{
+    // A parita di valore il max viene prima del min: AABB che si toccano
+    // soltanto non formano una coppia, come in AABB::Intersects
+    if (a.value != b.value)
+        return a.value < b.value;
+    return !a.isMin && b.isMin;
+}
+
+void SweepAndPrune::Update(const std::vector<RigidBody *> &bodies)
+{
+    updateStamp++;
+    swapCount = 0;
+    maxWidth = 0.0f;
+    size_t added = 0;
+
+    for (RigidBody *body : bodies) {
+        AABB bounds = GetBodyBounds(body, margin);
+
+        uint32_t id;
+        auto it = proxyOf.find(body);
+        if (it == proxyOf.end()) {
+            if (!freeProxies.empty()) {
+                id = freeProxies.back();
+                freeProxies.pop_back();
+            }
+            else {
+                id = static_cast<uint32_t>(proxies.size());
+                proxies.emplace_back();
+            }
+            proxies[id].body = body;
+            proxyOf[body] = id;
+            endpoints.push_back({ bounds.GetMinX(), id, true });
+            endpoints.push_back({ bounds.GetMaxX(), id, false });
+            added++;
+        }
+        else {
+            id = it->second;
+        }
+
+        Proxy &proxy = proxies[id];
+        proxy.minX = bounds.GetMinX();
+        proxy.maxX = bounds.GetMaxX();
+        proxy.minY = bounds.GetMinY();
+        proxy.maxY = bounds.GetMaxY();
+        proxy.stamp = updateStamp;
+        maxWidth = std::max(maxWidth, proxy.maxX - proxy.minX);
+    }
+
+    // Nessun duplicato in bodies: se le dimensioni differiscono qualcuno e stato rimosso
+    if (proxyOf.size() != bodies.size())
+        RemoveStaleProxies();
+
+    for (auto &e : endpoints) {
+        const Proxy &proxy = proxies[e.proxy];
+        e.value = e.isMin ? proxy.minX : proxy.maxX;
+    }
+
+    // Molti corpi nuovi (es. primo frame): l'insertion sort sarebbe O(n^2)
+    SortEndpoints(added * 4 > endpoints.size());
+}
+
+void SweepAndPrune::RemoveStaleProxies()
+{
+    for (auto it = proxyOf.begin(); it != proxyOf.end();) {
+        Proxy &proxy = proxies[it->second];
+        if (proxy.stamp == updateStamp) {
+            ++it;
+            continue;
+        }
+        proxy.body = nullptr;
+        freeProxies.push_back(it->second);
+        it = proxyOf.erase(it);
+    }
+
+    endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+        [this](const Endpoint &e) { return proxies[e.proxy].body == nullptr; }), endpoints.end());
+}
+
+void SweepAndPrune::SortEndpoints(bool fullSort)
+{
+    if (fullSort) {
+        std::sort(endpoints.begin(), endpoints.end(), EndpointLess);
+        return;
+    }
+
+    // Insertion sort: tra due frame gli estremi si spostano di poco
+    for (size_t i = 1; i < endpoints.size(); i++) {
+        Endpoint key = endpoints[i];
+        size_t j = i;
+        while (j > 0 && EndpointLess(key, endpoints[j - 1])) {
+            endpoints[j] = endpoints[j - 1];
+            j--;
+            swapCount++;
+        }
+        endpoints[j] = key;
+    }
+}
+
+void SweepAndPrune::FindPairs(std::vector<BroadphasePair> &pairs)
+{
+    pairs.clear();
+    active.clear();
+
+    for (const auto &e : endpoints) {
+        Proxy &proxy = proxies[e.proxy];
+
+        // Intervallo di larghezza nulla (AABB degenere, corpo puntiforme senza
+        // margine): il suo max arriva prima del min, quando non e ancora
+        // attivo. Si confronta al min con gli attivi e non entra nella lista.
+        bool point = !(proxy.minX < proxy.maxX);
+
+        if (!e.isMin) {
+            if (point)
+                continue;
+            // Fine dell'intervallo: togli dalla lista attiva (swap and pop)
+            uint32_t last = active.back();
+            active[proxy.activeIndex] = last;
+            proxies[last].activeIndex = proxy.activeIndex;
+            active.pop_back();
+            continue;
+        }
+
+        // Tutti gli attivi si sovrappongono gia su X: resta da controllare Y
+        for (uint32_t other : active) {
+            const Proxy &o = proxies[other];
+            if (proxy.minY < o.maxY && o.minY < proxy.maxY) {
+                if (proxy.body < o.body)
+                    pairs.push_back({ proxy.body, o.body });
+                else
+                    pairs.push_back({ o.body, proxy.body });
+            }
+        }
+
+        if (point)
+            continue;
+        proxy.activeIndex = static_cast<uint32_t>(active.size());
+        active.push_back(e.proxy);
+    }
+}
+
+void SweepAndPrune::Query(const AABB &range, std::vector<RigidBody *> &found)
+{
+    float minX = range.GetMinX(), maxX = range.GetMaxX();
+    float minY = range.GetMinY(), maxY = range.GetMaxY();
+
+    // Un corpo che tocca range ha il min su X non prima di minX - maxWidth:
+    // si parte da li con una ricerca binaria e ci si ferma a maxX
+    Endpoint key = { minX - maxWidth, 0, false };
+    auto it = std::lower_bound(endpoints.begin(), endpoints.end(), key, EndpointLess);
+
+    for (; it != endpoints.end() && it->value < maxX; ++it) {
+        // Solo gli estremi min: ogni corpo una volta sola
+        if (!it->isMin)
+            continue;
+
+        const Proxy &proxy = proxies[it->proxy];
+        if (minX < proxy.maxX && proxy.minY < maxY && minY < proxy.maxY)
+            found.push_back(proxy.body);
+    }
+}
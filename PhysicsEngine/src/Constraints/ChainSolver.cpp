@@ -0,0 +1,364 @@
+#include "Constraints/ChainSolver.h"
+#include <cmath>
+#include <algorithm>
+#include <cfloat>
+
+void ChainSolver::PushSlot(Vector2 *position, const RigidBody *body)
+{
+    // body nullptr = punto del pin; un corpo senza solverIndex e fisso nello step
+    slotPosition.push_back(position);
+    slotInverseMass.push_back(body && body->solverIndex >= 0 ? body->inverseMass : 0.0f);
+}
+
+void ChainSolver::Build(DistanceConstraint *distances, size_t distanceCount, PinConstraint *pins, size_t pinCount,
+    const IslandBuilder &islands, size_t nodeCount, bool xpbd)
+{
+    size_t constraintCount = distanceCount + pinCount;
+
+    // Estremi di un vincolo: lato 0 = A, lato 1 = B o il punto del pin (fisso)
+    auto nodeOf = [&](unsigned int c, int side) -> int {
+        if (c < distanceCount)
+            return (side == 0 ? distances[c].particleA : distances[c].particleB)->solverIndex;
+        return side == 0 ? pins[c - distanceCount].particleA->solverIndex : -1;
+    };
+
+    // 1. Vincoli ammessi e, per corpo, quanti ne ha e i primi due
+    linkState.assign(constraintCount, linkExcluded);
+    nodeDegree.assign(nodeCount, 0);
+    nodeLinks.assign(nodeCount * 2, 0);
+    for (unsigned int c = 0; c < constraintCount; c++) {
+        // Lunghezza nulla: direzione indefinita, resta al solver normale
+        bool rigid;
+        if (c < distanceCount)
+            rigid = (xpbd || distances[c].stiffness >= 1.0f) && distances[c].particleA != distances[c].particleB
+                && distances[c].restLength > 1e-6f;
+        else
+            rigid = (xpbd || pins[c - distanceCount].stiffness >= 1.0f) && pins[c - distanceCount].restLength > 1e-6f;
+
+        int nodes[2] = { nodeOf(c, 0), nodeOf(c, 1) };
+        if (!rigid || (nodes[0] < 0 && nodes[1] < 0))
+            continue;
+
+        linkState[c] = linkFree;
+        for (int node : nodes) {
+            if (node < 0)
+                continue;
+            if (nodeDegree[node] < 2)
+                nodeLinks[node * 2 + nodeDegree[node]] = c;
+            nodeDegree[node]++;
+        }
+    }
+
+    // 2. Percorsi da un estremo (fisso, pin o corpo con grado diverso da 2)
+    // attraverso i corpi interni. I cicli senza estremi restano fuori.
+    auto interior = [&](int node) { return node >= 0 && nodeDegree[node] == 2; };
+    auto pushEnd = [&](unsigned int c, int side) {
+        if (c < distanceCount) {
+            RigidBody *body = side == 0 ? distances[c].particleA : distances[c].particleB;
+            PushSlot(&body->position, body);
+        }
+        else if (side == 0) {
+            PushSlot(&pins[c - distanceCount].particleA->position, pins[c - distanceCount].particleA);
+        }
+        else {
+            PushSlot(&pins[c - distanceCount].pin, nullptr);
+        }
+    };
+
+    chains.clear();
+    links.clear();
+    linkRestLength.clear();
+    linkCompliance.clear();
+    linkLambda.clear();
+    slotPosition.clear();
+    slotInverseMass.clear();
+    for (unsigned int first = 0; first < constraintCount; first++) {
+        if (linkState[first] != linkFree)
+            continue;
+
+        int side = !interior(nodeOf(first, 0)) ? 0 : !interior(nodeOf(first, 1)) ? 1 : -1;
+        if (side < 0)
+            continue;  // In mezzo a una catena: la trova il suo estremo
+
+        Chain chain = { links.size(), 0, slotPosition.size() };
+        pushEnd(first, side);
+        unsigned int link = first;
+        for (;;) {
+            linkState[link] = linkVisited;
+            links.push_back(link);
+            if (link < distanceCount) {
+                linkRestLength.push_back(distances[link].restLength);
+                linkCompliance.push_back(distances[link].compliance);
+                linkLambda.push_back(&distances[link].lambda);
+            }
+            else {
+                linkRestLength.push_back(pins[link - distanceCount].restLength);
+                linkCompliance.push_back(pins[link - distanceCount].compliance);
+                linkLambda.push_back(&pins[link - distanceCount].lambda);
+            }
+
+            side = 1 - side;
+            pushEnd(link, side);
+            int node = nodeOf(link, side);
+            if (!interior(node))
+                break;
+
+            link = nodeLinks[node * 2] == link ? nodeLinks[node * 2 + 1] : nodeLinks[node * 2];
+            side = nodeOf(link, 0) == node ? 0 : 1;
+        }
+        chain.linkEnd = links.size();
+
+        // Un anello solo e gia esatto col solver normale; un percorso che
+        // torna al suo inizio non e tridiagonale
+        bool closed = slotPosition[chain.slotBegin] == slotPosition.back();
+        if (chain.linkEnd - chain.linkBegin < 2 || closed) {
+            links.resize(chain.linkBegin);
+            linkRestLength.resize(chain.linkBegin);
+            linkCompliance.resize(chain.linkBegin);
+            linkLambda.resize(chain.linkBegin);
+            slotPosition.resize(chain.slotBegin);
+            slotInverseMass.resize(chain.slotBegin);
+            continue;
+        }
+
+        for (size_t i = chain.linkBegin; i < chain.linkEnd; i++)
+            linkState[links[i]] = linkChained;
+        chains.push_back(chain);
+    }
+    linkScratch.resize(links.size());
+    blockScratch.resize(slotPosition.size());
+
+    // 3. Catene per isola (quella del loro primo anello) e vincoli rimasti
+    const auto &islandList = islands.GetIslands();
+    const auto &islandConstraints = islands.GetConstraints();
+    constraintIsland.assign(constraintCount, -1);
+    for (size_t i = 0; i < islandList.size(); i++) {
+        for (size_t k = islandList[i].constraintBegin; k < islandList[i].constraintEnd; k++)
+            constraintIsland[islandConstraints[k]] = static_cast<int>(i);
+    }
+
+    chainOffsets.assign(islandList.size() + 1, 0);
+    chainIsland.resize(chains.size());
+    for (size_t i = 0; i < chains.size(); i++) {
+        chainIsland[i] = constraintIsland[links[chains[i].linkBegin]];
+        chainOffsets[chainIsland[i] + 1]++;
+    }
+    for (size_t i = 0; i < islandList.size(); i++)
+        chainOffsets[i + 1] += chainOffsets[i];
+    islandChains.resize(chains.size());
+    for (size_t i = 0; i < chains.size(); i++)
+        islandChains[chainOffsets[chainIsland[i]]++] = static_cast<unsigned int>(i);
+    // Il riempimento ha spostato ogni offset all'inizio dell'isola successiva
+    for (size_t i = islandList.size(); i > 0; i--)
+        chainOffsets[i] = chainOffsets[i - 1];
+    chainOffsets[0] = 0;
+
+    looseConstraints.clear();
+    looseOffsets.assign(1, 0);
+    for (const Island &island : islandList) {
+        for (size_t k = island.constraintBegin; k < island.constraintEnd; k++) {
+            if (linkState[islandConstraints[k]] != linkChained)
+                looseConstraints.push_back(islandConstraints[k]);
+        }
+        looseOffsets.push_back(looseConstraints.size());
+    }
+}
+
+void ChainSolver::GetLooseConstraints(size_t island, const unsigned int *&begin, const unsigned int *&end) const
+{
+    begin = looseConstraints.data() + looseOffsets[island];
+    end = looseConstraints.data() + looseOffsets[island + 1];
+}
+
+float ChainSolver::Solve(size_t island, float inverseDt2)
+{
+    float maxError = 0.0f;
+    for (size_t i = chainOffsets[island]; i < chainOffsets[island + 1]; i++)
+        maxError = std::max(maxError, SolveChain(chains[islandChains[i]], inverseDt2));
+    return maxError;
+}
+
+// Matrici 3x3 per righe
+static bool Invert3(const double *m, double *inverse)
+{
+    double c0 = m[4] * m[8] - m[5] * m[7];
+    double c1 = m[5] * m[6] - m[3] * m[8];
+    double c2 = m[3] * m[7] - m[4] * m[6];
+    double determinant = m[0] * c0 + m[1] * c1 + m[2] * c2;
+    if (std::abs(determinant) < 1e-30)
+        return false;
+
+    double d = 1.0 / determinant;
+    inverse[0] = c0 * d;
+    inverse[1] = (m[2] * m[7] - m[1] * m[8]) * d;
+    inverse[2] = (m[1] * m[5] - m[2] * m[4]) * d;
+    inverse[3] = c1 * d;
+    inverse[4] = (m[0] * m[8] - m[2] * m[6]) * d;
+    inverse[5] = (m[2] * m[3] - m[0] * m[5]) * d;
+    inverse[6] = c2 * d;
+    inverse[7] = (m[1] * m[6] - m[0] * m[7]) * d;
+    inverse[8] = (m[0] * m[4] - m[1] * m[3]) * d;
+    return true;
+}
+
+static void Multiply3(const double *m, const double *v, double *result)
+{
+    for (int r = 0; r < 3; r++)
+        result[r] = m[r * 3] * v[0] + m[r * 3 + 1] * v[1] + m[r * 3 + 2] * v[2];
+}
+
+float ChainSolver::SolveChain(const Chain &chain, float inverseDt2)
+{
+    // Proiezione di x* (le posizioni all'ingresso): minimo di |x - x*|^2 in
+    // massa con C_i(x) + alpha_i lambda_tot_i = 0, C_i = |x_(i+1) - x_i| - L_i.
+    // Passo di Newton, e_i direzione dell'anello, t_i = max(-lambda_i, 0):
+    //   K dx - G^T dlambda = -(M (x - x*) - G^T lambda)
+    //   -G dx - alpha dlambda = C + alpha lambda_tot
+    // con G_i = (-e_i, e_i) su (x_i, x_(i+1)) e K = M + somma t_i (I - e_i e_i^T) / |x_(i+1) - x_i|
+    // sulle due posizioni dell'anello. Blocco j = (lambda_(j-1), x_j, y_j);
+    // per j = 0 lambda_(-1) e fittizio, un corpo fisso ha dx = 0.
+    size_t count = chain.linkEnd - chain.linkBegin;
+    Vector2 *const *position = &slotPosition[chain.slotBegin];
+    const float *inverseMass = &slotInverseMass[chain.slotBegin];
+    const float *restLength = &linkRestLength[chain.linkBegin];
+    const float *compliance = &linkCompliance[chain.linkBegin];
+    float *const *lambdaTotal = &linkLambda[chain.linkBegin];
+    LinkScratch *link = &linkScratch[chain.linkBegin];
+    BlockScratch *block = &blockScratch[chain.slotBegin];
+
+    for (size_t j = 0; j <= count; j++) {
+        block[j].referenceX = position[j]->x;
+        block[j].referenceY = position[j]->y;
+    }
+    for (size_t i = 0; i < count; i++)
+        link[i].lambda = 0.0;
+
+    float maxError = 0.0f;
+    for (int iteration = 0; iteration < maxNewtonIterations; iteration++) {
+        bool converged = true;
+        for (size_t i = 0; i < count; i++) {
+            double dx = static_cast<double>(position[i + 1]->x) - position[i]->x;
+            double dy = static_cast<double>(position[i + 1]->y) - position[i]->y;
+            double length = std::sqrt(dx * dx + dy * dy);
+            double error = length - restLength[i];
+            if (iteration == 0)
+                maxError = std::max(maxError, static_cast<float>(std::abs(error)));
+
+            LinkScratch &l = link[i];
+            l.length = std::max(length, 1e-9);
+            l.directionX = dx / l.length;
+            l.directionY = dy / l.length;
+            l.error = error + compliance[i] * inverseDt2 * (*lambdaTotal[i] + l.lambda);
+            // Tolleranza: 0.01% della lunghezza, ma non sotto la precisione dei float
+            double magnitude = std::max(std::abs(position[i]->x), std::abs(position[i]->y));
+            if (std::abs(l.error) > 1e-4 * restLength[i] + 4.0 * FLT_EPSILON * magnitude)
+                converged = false;
+        }
+        if (converged)
+            break;
+
+        // Eliminazione in avanti a blocchi
+        for (size_t j = 0; j <= count; j++) {
+            BlockScratch &b = block[j];
+            double diagonal[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+            b.rhs[0] = b.rhs[1] = b.rhs[2] = 0.0;
+            std::fill(b.upper, b.upper + 6, 0.0);
+            bool movable = inverseMass[j] > 0.0f;
+
+            if (j > 0) {
+                const LinkScratch &l = link[j - 1];
+                diagonal[0] = -compliance[j - 1] * inverseDt2;
+                b.rhs[0] = l.error;
+            }
+            if (movable) {
+                double mass = 1.0 / inverseMass[j];
+                double k[3] = { mass, 0.0, mass };  // xx, xy, yy
+                b.rhs[1] = -mass * (position[j]->x - b.referenceX);
+                b.rhs[2] = -mass * (position[j]->y - b.referenceY);
+                for (size_t i = j > 0 ? j - 1 : 0; i <= j && i < count; i++) {
+                    const LinkScratch &l = link[i];
+                    double tension = std::max(-l.lambda, 0.0) / l.length;
+                    k[0] += tension * (1.0 - l.directionX * l.directionX);
+                    k[1] -= tension * l.directionX * l.directionY;
+                    k[2] += tension * (1.0 - l.directionY * l.directionY);
+
+                    // G^T lambda: +lambda e sull'estremo B dell'anello, -lambda e su A
+                    double sign = i + 1 == j ? 1.0 : -1.0;
+                    b.rhs[1] += sign * l.lambda * l.directionX;
+                    b.rhs[2] += sign * l.lambda * l.directionY;
+                }
+                diagonal[4] = k[0];
+                diagonal[5] = diagonal[7] = k[1];
+                diagonal[8] = k[2];
+                if (j > 0) {
+                    diagonal[1] = diagonal[3] = -link[j - 1].directionX;
+                    diagonal[2] = diagonal[6] = -link[j - 1].directionY;
+                }
+                if (j < count) {
+                    const LinkScratch &l = link[j];
+                    b.upper[0] = l.directionX;
+                    b.upper[3] = l.directionY;
+                    if (inverseMass[j + 1] > 0.0f) {
+                        double tension = std::max(-l.lambda, 0.0) / l.length;
+                        b.upper[1] = -tension * (1.0 - l.directionX * l.directionX);
+                        b.upper[2] = b.upper[4] = tension * l.directionX * l.directionY;
+                        b.upper[5] = -tension * (1.0 - l.directionY * l.directionY);
+                    }
+                }
+            }
+
+            // S_j = D_j - U^T S_(j-1)^-1 U, rhs_j -= U^T S_(j-1)^-1 rhs_(j-1);
+            // U = upper del blocco precedente, con la riga di lambda nulla
+            if (j > 0) {
+                const BlockScratch &p = block[j - 1];
+                double upper[9] = { 0, 0, 0, p.upper[0], p.upper[1], p.upper[2], p.upper[3], p.upper[4], p.upper[5] };
+                double solved[9];  // S_(j-1)^-1 U
+                for (int c = 0; c < 3; c++) {
+                    double column[3] = { upper[c], upper[3 + c], upper[6 + c] };
+                    double result[3];
+                    Multiply3(p.inverse, column, result);
+                    solved[c] = result[0];
+                    solved[3 + c] = result[1];
+                    solved[6 + c] = result[2];
+                }
+                double solvedRhs[3];
+                Multiply3(p.inverse, p.rhs, solvedRhs);
+                for (int r = 0; r < 3; r++) {
+                    for (int c = 0; c < 3; c++)
+                        diagonal[r * 3 + c] -= upper[r] * solved[c] + upper[3 + r] * solved[3 + c] + upper[6 + r] * solved[6 + c];
+                    b.rhs[r] -= upper[r] * solvedRhs[0] + upper[3 + r] * solvedRhs[1] + upper[6 + r] * solvedRhs[2];
+                }
+            }
+            if (!Invert3(diagonal, b.inverse))
+                return maxError;  // Catena senza massa da spostare o anello di lunghezza nulla
+        }
+
+        // Sostituzione all'indietro: rhs diventa la soluzione del blocco
+        for (size_t j = count + 1; j-- > 0;) {
+            BlockScratch &b = block[j];
+            if (j < count) {
+                const double *next = block[j + 1].rhs;
+                b.rhs[1] -= b.upper[0] * next[0] + b.upper[1] * next[1] + b.upper[2] * next[2];
+                b.rhs[2] -= b.upper[3] * next[0] + b.upper[4] * next[1] + b.upper[5] * next[2];
+            }
+            double solution[3];
+            Multiply3(b.inverse, b.rhs, solution);
+            std::copy(solution, solution + 3, b.rhs);
+        }
+
+        for (size_t j = 0; j <= count; j++) {
+            if (j > 0)
+                link[j - 1].lambda += block[j].rhs[0];
+            if (inverseMass[j] > 0.0f) {
+                position[j]->x += static_cast<float>(block[j].rhs[1]);
+                position[j]->y += static_cast<float>(block[j].rhs[2]);
+            }
+        }
+    }
+
+    if (inverseDt2 > 0.0f) {
+        for (size_t i = 0; i < count; i++)
+            *lambdaTotal[i] += static_cast<float>(link[i].lambda);
+    }
+    return maxError;
+}
@@ -0,0 +1,324 @@
+#include "Constraints/DistanceBatch.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX_TARGET
+#define SSE2_TARGET
+#else
+#define AVX_TARGET __attribute__((target("avx")))
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+#endif
+
+DistanceBatchSolver::DistanceBatchSolver() : source(nullptr), fastInverseSqrt(false)
+{
+}
+
+void DistanceBatchSolver::Build(DistanceConstraint *constraints, const unsigned int *indices, size_t count, size_t bodyCount)
+{
+    source = constraints;
+
+    // Tipicamente (stoffa, corde) l'isola non cambia tra uno step e l'altro
+    bool sameList = builtIndices.size() == count && std::equal(indices, indices + count, builtIndices.begin());
+    if (sameList && Refresh())
+        return;
+
+    builtIndices.assign(indices, indices + count);
+    Color(indices, count, bodyCount);
+    Refresh();
+}
+
+void DistanceBatchSolver::Color(const unsigned int *indices, size_t count, size_t bodyCount)
+{
+    // Elementi della colorazione = posizioni nell'elenco, non indici dei vincoli
+    coloring.Begin(bodyCount);
+    for (size_t i = 0; i < count; i++) {
+        const DistanceConstraint &constraint = source[indices[i]];
+        coloring.Add(static_cast<unsigned int>(i), constraint.particleA->solverIndex, constraint.particleB->solverIndex);
+    }
+
+    laneOf.assign(count, noLane);
+    colorEnds.clear();
+    unsigned int lanes = 0;
+    for (size_t color = 0; color < coloring.GetColorCount(); color++) {
+        for (unsigned int item : coloring.GetColor(color))
+            laneOf[item] = lanes++;
+        colorEnds.push_back(lanes);
+    }
+    overflow.clear();
+    for (unsigned int item : coloring.GetOverflow())
+        overflow.push_back(indices[item]);
+
+    bodyA.assign(lanes, nullptr);
+    bodyB.assign(lanes, nullptr);
+    laneFixed.assign(lanes, 0);
+    restLength.resize(lanes);
+    weightA.resize(lanes);
+    weightB.resize(lanes);
+
+    for (size_t i = 0; i < count; i++) {
+        unsigned int lane = laneOf[i];
+        if (lane == noLane)
+            continue;
+        const DistanceConstraint &constraint = source[indices[i]];
+        bodyA[lane] = constraint.particleA;
+        bodyB[lane] = constraint.particleB;
+        laneFixed[lane] = (constraint.particleA->solverIndex == GraphColoring::fixedBody ? 1 : 0)
+            | (constraint.particleB->solverIndex == GraphColoring::fixedBody ? 2 : 0);
+    }
+}
+
+bool DistanceBatchSolver::Refresh()
+{
+    // Nell'ordine dell'elenco: vincoli e corpi letti quasi in sequenza
+    for (size_t k = 0; k < builtIndices.size(); k++) {
+        size_t i = laneOf[k];
+        if (i == noLane)
+            continue;
+        const DistanceConstraint &constraint = source[builtIndices[k]];
+        RigidBody *a = constraint.particleA;
+        RigidBody *b = constraint.particleB;
+        bool fixedA = a->solverIndex == GraphColoring::fixedBody;
+        bool fixedB = b->solverIndex == GraphColoring::fixedBody;
+
+        // Vincolo rimpiazzato o corpo diventato fisso / dinamico: colori da rifare
+        if (a != bodyA[i] || b != bodyB[i] || laneFixed[i] != ((fixedA ? 1 : 0) | (fixedB ? 2 : 0)))
+            return false;
+
+        // Fuori dalla colorazione = fisso: puo stare in piu corsie, quindi peso 0
+        float inverseMassA = fixedA ? 0.0f : a->inverseMass;
+        float inverseMassB = fixedB ? 0.0f : b->inverseMass;
+        float inverseMassTotal = inverseMassA + inverseMassB;
+
+        restLength[i] = constraint.restLength;
+        if (inverseMassTotal < 1e-6f) {
+            weightA[i] = 0.0f;
+            weightB[i] = 0.0f;
+        }
+        else {
+            weightA[i] = constraint.stiffness * (inverseMassA / inverseMassTotal);
+            weightB[i] = constraint.stiffness * (inverseMassB / inverseMassTotal);
+        }
+    }
+    return true;
+}
+
+// Corsia singola, stesse operazioni delle corsie vettoriali. Ritorna l'errore.
+static inline float SolveLane(RigidBody *a, RigidBody *b, float rest, float wA, float wB, bool fast)
+{
+    float dx = b->position.x - a->position.x;
+    float dy = b->position.y - a->position.y;
+    float d2 = dx * dx + dy * dy;
+    float length = std::sqrt(d2);
+    float error = length - rest;
+
+    if (std::abs(error) < 1e-6f || length < 1e-6f || wA + wB <= 0.0f)
+        return 0.0f;
+
+    // error / length, oppure error * rsqrt(d2) con un passo di Newton
+    float scale;
+#ifdef PHYSICS_SIMD
+    if (fast) {
+        float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(d2)));
+        y = y * (1.5f - 0.5f * d2 * y * y);
+        scale = error * y;
+    }
+    else
+#else
+    (void)fast;
+#endif
+        scale = error / length;
+
+    a->position.x += dx * scale * wA;
+    a->position.y += dy * scale * wA;
+    b->position.x -= dx * scale * wB;
+    b->position.y -= dy * scale * wB;
+    return std::abs(error);
+}
+
+static float SolveScalar(RigidBody *const *bodyA, RigidBody *const *bodyB, const float *rest, const float *wA, const float *wB,
+    size_t begin, size_t end, bool fast)
+{
+    float maxError = 0.0f;
+    for (size_t i = begin; i < end; i++)
+        maxError = std::max(maxError, SolveLane(bodyA[i], bodyB[i], rest[i], wA[i], wB[i], fast));
+    return maxError;
+}
+
+#ifdef PHYSICS_SIMD
+
+// Le scritture sono senza condizioni: un corpo fisso ha peso 0 e riscrive il suo valore
+
+SSE2_TARGET static size_t SolveSSE2(RigidBody *const *bodyA, RigidBody *const *bodyB, const float *rest, const float *wA, const float *wB,
+    size_t begin, size_t end, bool fast, float &maxError)
+{
+    __m128 maxError4 = _mm_setzero_ps();
+    const __m128 epsilon = _mm_set1_ps(1e-6f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 threeHalves = _mm_set1_ps(1.5f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        RigidBody *const *a = bodyA + i;
+        RigidBody *const *b = bodyB + i;
+        __m128 ax = _mm_setr_ps(a[0]->position.x, a[1]->position.x, a[2]->position.x, a[3]->position.x);
+        __m128 ay = _mm_setr_ps(a[0]->position.y, a[1]->position.y, a[2]->position.y, a[3]->position.y);
+        __m128 bx = _mm_setr_ps(b[0]->position.x, b[1]->position.x, b[2]->position.x, b[3]->position.x);
+        __m128 by = _mm_setr_ps(b[0]->position.y, b[1]->position.y, b[2]->position.y, b[3]->position.y);
+
+        __m128 dx = _mm_sub_ps(bx, ax);
+        __m128 dy = _mm_sub_ps(by, ay);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 length = _mm_sqrt_ps(d2);
+        __m128 error = _mm_sub_ps(length, _mm_loadu_ps(rest + i));
+
+        // Corsie gia a posto o degeneri: correzione 0 (niente divisione per zero)
+        __m128 absError = _mm_and_ps(error, absMask);
+        __m128 active = _mm_and_ps(_mm_cmpge_ps(absError, epsilon), _mm_cmpge_ps(length, epsilon));
+
+        __m128 scale;
+        if (fast) {
+            __m128 y = _mm_rsqrt_ps(d2);
+            y = _mm_mul_ps(y, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, d2), _mm_mul_ps(y, y))));
+            scale = _mm_mul_ps(error, y);
+        }
+        else {
+            scale = _mm_div_ps(error, length);
+        }
+        scale = _mm_and_ps(scale, active);
+
+        __m128 sx = _mm_mul_ps(dx, scale);
+        __m128 sy = _mm_mul_ps(dy, scale);
+        __m128 weightA = _mm_loadu_ps(wA + i);
+        __m128 weightB = _mm_loadu_ps(wB + i);
+        __m128 movable = _mm_cmpgt_ps(_mm_add_ps(weightA, weightB), _mm_setzero_ps());
+        maxError4 = _mm_max_ps(maxError4, _mm_and_ps(absError, _mm_and_ps(active, movable)));
+
+        alignas(16) float outAx[4], outAy[4], outBx[4], outBy[4];
+        _mm_store_ps(outAx, _mm_add_ps(ax, _mm_mul_ps(sx, weightA)));
+        _mm_store_ps(outAy, _mm_add_ps(ay, _mm_mul_ps(sy, weightA)));
+        _mm_store_ps(outBx, _mm_sub_ps(bx, _mm_mul_ps(sx, weightB)));
+        _mm_store_ps(outBy, _mm_sub_ps(by, _mm_mul_ps(sy, weightB)));
+
+        for (int lane = 0; lane < 4; lane++) {
+            a[lane]->position.x = outAx[lane];
+            a[lane]->position.y = outAy[lane];
+            b[lane]->position.x = outBx[lane];
+            b[lane]->position.y = outBy[lane];
+        }
+    }
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, maxError4);
+    for (float value : lanes)
+        maxError = std::max(maxError, value);
+    return i;
+}
+
+AVX_TARGET static size_t SolveAVX(RigidBody *const *bodyA, RigidBody *const *bodyB, const float *rest, const float *wA, const float *wB,
+    size_t begin, size_t end, bool fast, float &maxError)
+{
+    __m256 maxError8 = _mm256_setzero_ps();
+    const __m256 epsilon = _mm256_set1_ps(1e-6f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        RigidBody *const *a = bodyA + i;
+        RigidBody *const *b = bodyB + i;
+        __m256 ax = _mm256_setr_ps(a[0]->position.x, a[1]->position.x, a[2]->position.x, a[3]->position.x,
+            a[4]->position.x, a[5]->position.x, a[6]->position.x, a[7]->position.x);
+        __m256 ay = _mm256_setr_ps(a[0]->position.y, a[1]->position.y, a[2]->position.y, a[3]->position.y,
+            a[4]->position.y, a[5]->position.y, a[6]->position.y, a[7]->position.y);
+        __m256 bx = _mm256_setr_ps(b[0]->position.x, b[1]->position.x, b[2]->position.x, b[3]->position.x,
+            b[4]->position.x, b[5]->position.x, b[6]->position.x, b[7]->position.x);
+        __m256 by = _mm256_setr_ps(b[0]->position.y, b[1]->position.y, b[2]->position.y, b[3]->position.y,
+            b[4]->position.y, b[5]->position.y, b[6]->position.y, b[7]->position.y);
+
+        __m256 dx = _mm256_sub_ps(bx, ax);
+        __m256 dy = _mm256_sub_ps(by, ay);
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 length = _mm256_sqrt_ps(d2);
+        __m256 error = _mm256_sub_ps(length, _mm256_loadu_ps(rest + i));
+
+        __m256 absError = _mm256_and_ps(error, absMask);
+        __m256 active = _mm256_and_ps(_mm256_cmp_ps(absError, epsilon, _CMP_GE_OQ), _mm256_cmp_ps(length, epsilon, _CMP_GE_OQ));
+
+        __m256 scale;
+        if (fast) {
+            __m256 y = _mm256_rsqrt_ps(d2);
+            y = _mm256_mul_ps(y, _mm256_sub_ps(threeHalves, _mm256_mul_ps(_mm256_mul_ps(half, d2), _mm256_mul_ps(y, y))));
+            scale = _mm256_mul_ps(error, y);
+        }
+        else {
+            scale = _mm256_div_ps(error, length);
+        }
+        scale = _mm256_and_ps(scale, active);
+
+        __m256 sx = _mm256_mul_ps(dx, scale);
+        __m256 sy = _mm256_mul_ps(dy, scale);
+        __m256 weightA = _mm256_loadu_ps(wA + i);
+        __m256 weightB = _mm256_loadu_ps(wB + i);
+        __m256 movable = _mm256_cmp_ps(_mm256_add_ps(weightA, weightB), _mm256_setzero_ps(), _CMP_GT_OQ);
+        maxError8 = _mm256_max_ps(maxError8, _mm256_and_ps(absError, _mm256_and_ps(active, movable)));
+
+        alignas(32) float outAx[8], outAy[8], outBx[8], outBy[8];
+        _mm256_store_ps(outAx, _mm256_add_ps(ax, _mm256_mul_ps(sx, weightA)));
+        _mm256_store_ps(outAy, _mm256_add_ps(ay, _mm256_mul_ps(sy, weightA)));
+        _mm256_store_ps(outBx, _mm256_sub_ps(bx, _mm256_mul_ps(sx, weightB)));
+        _mm256_store_ps(outBy, _mm256_sub_ps(by, _mm256_mul_ps(sy, weightB)));
+
+        for (int lane = 0; lane < 8; lane++) {
+            a[lane]->position.x = outAx[lane];
+            a[lane]->position.y = outAy[lane];
+            b[lane]->position.x = outBx[lane];
+            b[lane]->position.y = outBy[lane];
+        }
+    }
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, maxError8);
+    for (float value : lanes)
+        maxError = std::max(maxError, value);
+    return i;
+}
+
+#endif
+
+float DistanceBatchSolver::Solve()
+{
+    return Solve(CpuFeatures::GetSimdLevel());
+}
+
+float DistanceBatchSolver::Solve(SimdLevel level)
+{
+    float maxError = 0.0f;
+    size_t begin = 0;
+    for (size_t end : colorEnds) {
+        size_t done = begin;
+
+#ifdef PHYSICS_SIMD
+        if (level == SimdLevel::AVX)
+            done = SolveAVX(bodyA.data(), bodyB.data(), restLength.data(), weightA.data(), weightB.data(), begin, end, fastInverseSqrt, maxError);
+        else if (level == SimdLevel::SSE2)
+            done = SolveSSE2(bodyA.data(), bodyB.data(), restLength.data(), weightA.data(), weightB.data(), begin, end, fastInverseSqrt, maxError);
+#else
+        (void)level;
+#endif
+
+        // Coda del colore (o tutto il colore senza SIMD)
+        maxError = std::max(maxError, SolveScalar(bodyA.data(), bodyB.data(), restLength.data(), weightA.data(), weightB.data(), done, end, fastInverseSqrt));
+        begin = end;
+    }
+
+    for (unsigned int index : overflow)
+        maxError = std::max(maxError, source[index].Solve());
+    return maxError;
+}
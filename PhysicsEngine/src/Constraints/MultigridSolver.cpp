@@ -0,0 +1,210 @@
+#include "Constraints/MultigridSolver.h"
+#include <cfloat>
+#include <algorithm>
+
+void MultigridSolver::Build(DistanceConstraint *constraints, const unsigned int *indices, size_t count)
+{
+    // Stesso elenco, stessi corpi, stesse lunghezze: la gerarchia vale ancora
+    bool same = builtIndices.size() == count && std::equal(indices, indices + count, builtIndices.begin());
+    for (size_t i = 0; same && i < count; i++) {
+        const DistanceConstraint &constraint = constraints[indices[i]];
+        same = builtBodies[i * 2] == constraint.particleA && builtBodies[i * 2 + 1] == constraint.particleB
+            && builtRestLengths[i] == constraint.restLength;
+    }
+    if (same)
+        return;
+
+    builtIndices.assign(indices, indices + count);
+    builtBodies.resize(count * 2);
+    builtRestLengths.resize(count);
+    nodeBodies.clear();
+    nodeOf.clear();
+    levels.clear();
+
+    // Livello fine: un nodo per corpo, nell'ordine di comparsa
+    auto localNode = [&](RigidBody *body) {
+        auto found = nodeOf.emplace(body, static_cast<unsigned int>(nodeBodies.size()));
+        if (found.second)
+            nodeBodies.push_back(body);
+        return found.first->second;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const DistanceConstraint &constraint = constraints[indices[i]];
+        builtBodies[i * 2] = constraint.particleA;
+        builtBodies[i * 2 + 1] = constraint.particleB;
+        builtRestLengths[i] = constraint.restLength;
+        if (constraint.particleA == constraint.particleB)
+            continue;
+        edges.push_back({ localNode(constraint.particleA), localNode(constraint.particleB), constraint.restLength, constraint.stiffness });
+    }
+
+    std::vector<unsigned int> nodes(nodeBodies.size());
+    for (unsigned int i = 0; i < nodes.size(); i++)
+        nodes[i] = i;
+
+    // Un livello in piu finche dimezza davvero i nodi e ne restano abbastanza
+    while (nodes.size() >= minLevelNodes * 2) {
+        Level coarse;
+        BuildLevel(nodes, edges, coarse);
+        if (coarse.nodes.size() < minLevelNodes || coarse.edges.empty() || coarse.nodes.size() * 2 > nodes.size())
+            break;
+        levels.push_back(std::move(coarse));
+        nodes = levels.back().nodes;
+        edges = levels.back().edges;
+    }
+}
+
+void MultigridSolver::BuildLevel(const std::vector<unsigned int> &nodes, const std::vector<Edge> &edges, Level &coarse)
+{
+    size_t nodeCount = nodeBodies.size();
+
+    // Adiacenza del livello (CSR sui nodi locali)
+    adjacencyOffsets.assign(nodeCount + 1, 0);
+    for (const Edge &edge : edges) {
+        adjacencyOffsets[edge.a + 1]++;
+        adjacencyOffsets[edge.b + 1]++;
+    }
+    for (size_t i = 0; i < nodeCount; i++)
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    adjacency.resize(edges.size() * 2);
+    adjacencyEdges.resize(edges.size() * 2);
+    touched.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (unsigned int e = 0; e < edges.size(); e++) {
+        adjacency[touched[edges[e].a]] = edges[e].b;
+        adjacencyEdges[touched[edges[e].a]++] = e;
+        adjacency[touched[edges[e].b]] = edges[e].a;
+        adjacencyEdges[touched[edges[e].b]++] = e;
+    }
+
+    // Insieme indipendente massimale, prima i nodi fissi: restano ancore
+    // anche sui livelli grossolani. Ogni nodo scartato ha un vicino scelto.
+    coarseIndex.assign(nodeCount, freeNode);
+    for (int pass = 0; pass < 2; pass++) {
+        for (unsigned int node : nodes) {
+            bool fixed = InverseMass(node) == 0.0f;
+            if (coarseIndex[node] != freeNode || fixed != (pass == 0) || adjacencyOffsets[node] == adjacencyOffsets[node + 1])
+                continue;
+            coarseIndex[node] = static_cast<int>(coarse.nodes.size());
+            coarse.nodes.push_back(node);
+            for (unsigned int a = adjacencyOffsets[node]; a < adjacencyOffsets[node + 1]; a++) {
+                if (coarseIndex[adjacency[a]] == freeNode)
+                    coarseIndex[adjacency[a]] = coveredNode;
+            }
+        }
+    }
+
+    // Vincoli grossolani: nodi scelti a due vincoli di distanza (a uno non
+    // ce ne sono, l'insieme e indipendente). Lunghezza = cammino piu corto.
+    bestRest.assign(nodeCount, FLT_MAX);
+    bestStiffness.assign(nodeCount, 0.0f);
+    for (unsigned int node : coarse.nodes) {
+        touched.clear();
+        for (unsigned int a = adjacencyOffsets[node]; a < adjacencyOffsets[node + 1]; a++) {
+            unsigned int middle = adjacency[a];
+            const Edge &first = edges[adjacencyEdges[a]];
+            for (unsigned int b = adjacencyOffsets[middle]; b < adjacencyOffsets[middle + 1]; b++) {
+                unsigned int other = adjacency[b];
+                if (coarseIndex[other] <= coarseIndex[node])
+                    continue;
+                const Edge &second = edges[adjacencyEdges[b]];
+                float rest = first.restLength + second.restLength;
+                if (bestRest[other] == FLT_MAX)
+                    touched.push_back(other);
+                if (rest < bestRest[other]) {
+                    bestRest[other] = rest;
+                    bestStiffness[other] = std::min(first.stiffness, second.stiffness);
+                }
+            }
+        }
+        for (unsigned int other : touched) {
+            coarse.edges.push_back({ node, other, bestRest[other], bestStiffness[other] });
+            bestRest[other] = FLT_MAX;
+        }
+    }
+
+    // Prolungamento: i nodi scartati prendono la media delle correzioni dei
+    // vicini scelti, pesata con l'inverso della lunghezza del vincolo
+    coarse.parentOffsets.push_back(0);
+    for (unsigned int node : nodes) {
+        if (coarseIndex[node] >= 0)
+            continue;
+        size_t first = coarse.parents.size();
+        float totalWeight = 0.0f;
+        for (unsigned int a = adjacencyOffsets[node]; a < adjacencyOffsets[node + 1]; a++) {
+            int parent = coarseIndex[adjacency[a]];
+            if (parent < 0)
+                continue;
+            float weight = 1.0f / std::max(edges[adjacencyEdges[a]].restLength, 1e-6f);
+            coarse.parents.push_back(static_cast<unsigned int>(parent));
+            coarse.parentWeights.push_back(weight);
+            totalWeight += weight;
+        }
+        for (size_t p = first; p < coarse.parents.size(); p++)
+            coarse.parentWeights[p] /= totalWeight;
+        coarse.fineNodes.push_back(node);
+        coarse.parentOffsets.push_back(static_cast<unsigned int>(coarse.parents.size()));
+    }
+    coarse.entryPositions.resize(coarse.nodes.size());
+}
+
+float MultigridSolver::InverseMass(unsigned int node) const
+{
+    const RigidBody *body = nodeBodies[node];
+    return body->solverIndex >= 0 ? body->inverseMass : 0.0f;
+}
+
+void MultigridSolver::Relax(const Level &level)
+{
+    // Unilatero: solo l'allungamento oltre il cammino di riposo
+    for (const Edge &edge : level.edges) {
+        float inverseMassA = InverseMass(edge.a);
+        float inverseMassB = InverseMass(edge.b);
+        float inverseMassTotal = inverseMassA + inverseMassB;
+        if (inverseMassTotal <= 0.0f)
+            continue;
+
+        Vector2 &positionA = nodeBodies[edge.a]->position;
+        Vector2 &positionB = nodeBodies[edge.b]->position;
+        Vector2 delta = positionB - positionA;
+        float length = delta.Length();
+        if (length <= edge.restLength)
+            continue;
+
+        Vector2 correction = delta * ((length - edge.restLength) * edge.stiffness / (length * inverseMassTotal));
+        positionA += correction * inverseMassA;
+        positionB -= correction * inverseMassB;
+    }
+}
+
+void MultigridSolver::VCycle(size_t level)
+{
+    Level &current = levels[level];
+    for (size_t i = 0; i < current.nodes.size(); i++)
+        current.entryPositions[i] = nodeBodies[current.nodes[i]]->position;
+
+    Relax(current);
+    if (level + 1 < levels.size())
+        VCycle(level + 1);
+    Relax(current);
+
+    // Correzione del livello portata ai nodi del livello sotto che non ne fanno parte
+    for (size_t i = 0; i < current.fineNodes.size(); i++) {
+        unsigned int node = current.fineNodes[i];
+        if (InverseMass(node) == 0.0f)
+            continue;
+        Vector2 correction(0.0f, 0.0f);
+        for (unsigned int p = current.parentOffsets[i]; p < current.parentOffsets[i + 1]; p++) {
+            unsigned int parent = current.parents[p];
+            correction += (nodeBodies[current.nodes[parent]]->position - current.entryPositions[parent]) * current.parentWeights[p];
+        }
+        nodeBodies[node]->position += correction;
+    }
+}
+
+void MultigridSolver::Solve()
+{
+    if (!levels.empty())
+        VCycle(0);
+}
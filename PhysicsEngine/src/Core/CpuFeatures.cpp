@@ -0,0 +1,52 @@
+#include "Core/CpuFeatures.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+static SimdLevel DetectSimdLevel()
+{
+#if defined(PHYSICS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+
+    // AVX serve anche il salvataggio dei registri YMM da parte del sistema
+    if (avx && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+        return SimdLevel::AVX;
+    if (sse2)
+        return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+#elif defined(PHYSICS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx"))
+        return SimdLevel::AVX;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+SimdLevel CpuFeatures::GetSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+const char *CpuFeatures::GetName(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::AVX:  return "AVX";
+    case SimdLevel::SSE2: return "SSE2";
+    default:              return "scalare";
+    }
+}
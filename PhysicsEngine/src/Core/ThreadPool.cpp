@@ -0,0 +1,90 @@
+#include "Core/ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : job(nullptr), jobCount(0), chunkSize(1), nextChunk(0), generation(0), pending(0), stopping(false)
+{
+    for (unsigned int i = 1; i < threadCount; i++)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)> &work, size_t minParallel)
+{
+    if (count == 0)
+        return;
+
+    if (workers.empty() || count < minParallel) {
+        work(0, count);
+        return;
+    }
+
+    // Qualche blocco per thread: bilancia il carico senza troppi atomici
+    job = &work;
+    jobCount = count;
+    chunkSize = std::max<size_t>(1, count / (GetThreadCount() * 4));
+    nextChunk.store(0, std::memory_order_relaxed);
+    pending.store(static_cast<unsigned int>(workers.size()), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_all();
+
+    RunChunks();
+
+    while (pending.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+}
+
+void ThreadPool::RunChunks()
+{
+    for (;;) {
+        size_t begin = nextChunk.fetch_add(chunkSize, std::memory_order_relaxed);
+        if (begin >= jobCount)
+            return;
+        (*job)(begin, std::min(begin + chunkSize, jobCount));
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    const int spinCount = 2000;
+    unsigned int seen = 0;
+
+    for (;;) {
+        // Attesa attiva breve, poi si dorme sulla condition variable
+        int spins = 0;
+        while (generation.load(std::memory_order_acquire) == seen && spins < spinCount) {
+            std::this_thread::yield();
+            spins++;
+        }
+
+        if (generation.load(std::memory_order_acquire) == seen) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return generation.load(std::memory_order_acquire) != seen; });
+        }
+
+        seen = generation.load(std::memory_order_acquire);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+        }
+
+        RunChunks();
+        pending.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -2,19 +2,19 @@
 
 RigidBody *MouseHandler::FindBodyAtPosition(const Vector2 &worldPos, PhysicsWorld &world)
 {
-    auto &bodies = world.GetBodies();
-    for (auto &body : bodies) {
-        if (body->shapeType == ShapeType::CIRCLE) {
-            if (Vector2::DistanceSquared(body->position, worldPos) <= (body->radius * body->radius))
-                return body.get();
-        }
-        else if (body->shapeType == ShapeType::AABB) {
-            if (worldPos.x >= body->GetMinX() && worldPos.x <= body->GetMaxX() && worldPos.y >= body->GetMinY() && worldPos.y <= body->GetMaxY()) {
-                return body.get();
-            }
+    world.QueryPoint(worldPos, pickResults);
+
+    // Corpi sovrapposti sotto il cursore: prendi quello col centro piu vicino
+    RigidBody *closest = nullptr;
+    float closestDistance = 0.0f;
+    for (RigidBody *body : pickResults) {
+        float distance = Vector2::DistanceSquared(body->position, worldPos);
+        if (!closest || distance < closestDistance) {
+            closest = body;
+            closestDistance = distance;
         }
     }
-    return nullptr;
+    return closest;
 }
 
 MouseHandler::MouseHandler(float stiffness, float damping)
@@ -0,0 +1,45 @@
+#include "Physics/GraphColoring.h"
+
+GraphColoring::GraphColoring() : colorCount(0)
+{
+}
+
+void GraphColoring::Begin(size_t bodyCount)
+{
+    bodyMasks.assign(bodyCount, 0);
+    for (size_t i = 0; i < colorCount; i++)
+        colors[i].clear();
+    overflow.clear();
+    colorCount = 0;
+}
+
+void GraphColoring::Add(unsigned int item, int bodyA, int bodyB)
+{
+    uint64_t used = 0;
+    if (bodyA != fixedBody)
+        used |= bodyMasks[bodyA];
+    if (bodyB != fixedBody)
+        used |= bodyMasks[bodyB];
+
+    if (used == ~uint64_t(0)) {
+        overflow.push_back(item);
+        return;
+    }
+
+    // Primo bit libero
+    int color = 0;
+    while (used & (uint64_t(1) << color))
+        color++;
+
+    uint64_t bit = uint64_t(1) << color;
+    if (bodyA != fixedBody)
+        bodyMasks[bodyA] |= bit;
+    if (bodyB != fixedBody)
+        bodyMasks[bodyB] |= bit;
+
+    if (static_cast<size_t>(color) >= colors.size())
+        colors.resize(color + 1);
+    if (static_cast<size_t>(color) >= colorCount)
+        colorCount = color + 1;
+    colors[color].push_back(item);
+}
@@ -0,0 +1,111 @@
+#include "Physics/IslandBuilder.h"
+#include "Physics/RigidBody.h"
+
+int IslandBuilder::Find(int node)
+{
+    // Path halving: ogni nodo visitato salta al nonno
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void IslandBuilder::Union(int a, int b)
+{
+    if (a < 0 || b < 0)
+        return;
+
+    a = Find(a);
+    b = Find(b);
+    if (a == b)
+        return;
+
+    // Radice = indice minore, cosi la radice non dipende dall'ordine delle unioni
+    if (a < b)
+        parent[b] = a;
+    else
+        parent[a] = b;
+}
+
+void IslandBuilder::Begin(size_t nodeCount)
+{
+    parent.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++)
+        parent[i] = static_cast<int>(i);
+
+    pairNodes.clear();
+    constraintNodes.clear();
+}
+
+void IslandBuilder::AddPair(int nodeA, int nodeB)
+{
+    Union(nodeA, nodeB);
+    pairNodes.push_back(nodeA >= 0 ? nodeA : nodeB);
+}
+
+void IslandBuilder::AddConstraint(int nodeA, int nodeB)
+{
+    Union(nodeA, nodeB);
+    constraintNodes.push_back(nodeA >= 0 ? nodeA : nodeB);
+}
+
+void IslandBuilder::Build(const std::vector<std::unique_ptr<RigidBody>> &worldBodies, int defaultIterations)
+{
+    // Un'isola per radice, numerate nell'ordine dei corpi del mondo
+    islandOfRoot.assign(parent.size(), -1);
+    islands.clear();
+    for (const auto &body : worldBodies) {
+        if (body->solverIndex < 0)
+            continue;
+
+        int root = Find(body->solverIndex);
+        if (islandOfRoot[root] < 0) {
+            islandOfRoot[root] = static_cast<int>(islands.size());
+            islands.push_back({ 0, 0, 0, 0, 0, 0, defaultIterations, 0, 0.0f });
+        }
+        islands[islandOfRoot[root]].bodyEnd++;
+    }
+
+    for (int node : pairNodes) {
+        if (node >= 0)
+            islands[islandOfRoot[Find(node)]].pairEnd++;
+    }
+    for (int node : constraintNodes) {
+        if (node >= 0)
+            islands[islandOfRoot[Find(node)]].constraintEnd++;
+    }
+
+    // Counting sort: i conteggi diventano intervalli contigui
+    size_t bodyOffset = 0, pairOffset = 0, constraintOffset = 0;
+    for (auto &island : islands) {
+        island.bodyBegin = bodyOffset;
+        bodyOffset += island.bodyEnd;
+        island.bodyEnd = island.bodyBegin;
+
+        island.pairBegin = pairOffset;
+        pairOffset += island.pairEnd;
+        island.pairEnd = island.pairBegin;
+
+        island.constraintBegin = constraintOffset;
+        constraintOffset += island.constraintEnd;
+        island.constraintEnd = island.constraintBegin;
+    }
+
+    bodies.resize(bodyOffset);
+    pairs.resize(pairOffset);
+    constraints.resize(constraintOffset);
+
+    for (const auto &body : worldBodies) {
+        if (body->solverIndex >= 0)
+            bodies[islands[islandOfRoot[Find(body->solverIndex)]].bodyEnd++] = body.get();
+    }
+    for (size_t i = 0; i < pairNodes.size(); i++) {
+        if (pairNodes[i] >= 0)
+            pairs[islands[islandOfRoot[Find(pairNodes[i])]].pairEnd++] = static_cast<unsigned int>(i);
+    }
+    for (size_t i = 0; i < constraintNodes.size(); i++) {
+        if (constraintNodes[i] >= 0)
+            constraints[islands[islandOfRoot[Find(constraintNodes[i])]].constraintEnd++] = static_cast<unsigned int>(i);
+    }
+}
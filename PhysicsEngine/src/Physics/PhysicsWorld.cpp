@@ -1,33 +1,157 @@
 ﻿#include "Physics/PhysicsWorld.h"
 #include "Collision/CollisionDetection.h"
+#include "Collision/QuadTreeBroadphase.h"
+#include "Collision/SweepAndPrune.h"
+#include "Collision/SpatialHashGrid.h"
+#include "Collision/DynamicAABBTree.h"
+#include "Collision/LinearQuadTree.h"
+#include "Collision/LooseQuadTree.h"
+#include "Collision/CircleBatch.h"
 #include <iostream>
+#include <algorithm>
+#include <atomic>
 
-PhysicsWorld::PhysicsWorld()
-    : gravity(Vector2(0.0f, -9.8f)),
+PhysicsWorld::PhysicsWorld(BroadphaseType type)
+    : solverIterations(5),
+    solverTolerance(0.0f),
+    lastIterations(0),
+    lastResidual(0.0f),
+    warmStarting(true),
+    solverNodeCount(0),
+    lastColorCount(0),
+    constraintBatching(false),
+    batchFastInverseSqrt(false),
+    chainSolving(false),
+    multigridSolving(false),
+    xpbdSubsteps(0),
+    xpbdInverseDt2(0.0f),
+    jacobiEnabled(false),
+    jacobiRelaxation(1.0f),
+    chebyshevEnabled(false),
+    chebyshevRadius(0.9f),
+    chebyshevWarmup(2),
+    sleepingEnabled(true),
+    sleepTolerance(0.02f),
+    timeToSleep(0.5f),
+    sleepingBodyCount(0),
+    sleepingChanged(false),
+    broadphaseType(type),
+    broadphaseDirty(true),
+    staticsDirty(true),
+    circlePruning(true),
+    gravity(Vector2(0.0f, -9.8f)),
     fixedTimeStep(1.0f / 60.0f),
     timeAccumulator(0.0f)
 {
-    // Crea QuadTree per tutto il mondo (es. 20x15 centrato in 10, 7.5)
-    AABB worldBounds(Vector2(10, 7.5f), 10.0f, 7.5f);
-    quadTree = std::make_unique<QuadTree>(worldBounds, 4);  // capacity = 4
+    switch (type) {
+    case BroadphaseType::SWEEP_AND_PRUNE:
+        broadphase = std::make_unique<SweepAndPrune>();
+        break;
+    case BroadphaseType::SPATIAL_HASH:
+        broadphase = std::make_unique<SpatialHashGrid>();
+        break;
+    case BroadphaseType::DYNAMIC_AABB_TREE:
+        broadphase = std::make_unique<DynamicAABBTree>();
+        break;
+    case BroadphaseType::LINEAR_QUADTREE:
+        broadphase = std::make_unique<LinearQuadTree>();
+        break;
+    case BroadphaseType::LOOSE_QUADTREE:
+        broadphase = std::make_unique<LooseQuadTree>();
+        break;
+    case BroadphaseType::QUADTREE:
+    default: {
+        // Crea QuadTree per tutto il mondo (es. 20x15 centrato in 10, 7.5)
+        AABB worldBounds(Vector2(10, 7.5f), 10.0f, 7.5f);
+        broadphase = std::make_unique<QuadTreeBroadphase>(worldBounds, 4);  // capacity = 4
+        break;
+    }
+    }
+
+    // Statici: BVH senza bound del mondo, interrogata una volta per corpo
+    // dinamico. Solo query: le coppie statico-statico non servono.
+    staticBroadphase = std::make_unique<DynamicAABBTree>(broadphase->GetMargin(), 0.0f, false);
 }
 
 RigidBody *PhysicsWorld::CreateRigidBody(const Vector2 &position, float mass)
 {
     bodies.emplace_back(std::make_unique<RigidBody>(position, mass));
+    broadphaseDirty = true;
     return bodies.back().get();
 }
 
-DistanceConstraint *PhysicsWorld::CreateDistanceConstraint(RigidBody *bodyA, RigidBody *bodyB, float stiff)
+ConstraintHandle PhysicsWorld::CreateDistanceConstraint(RigidBody *bodyA, RigidBody *bodyB, float stiff)
 {
-    constraints.emplace_back(std::make_unique<DistanceConstraint>(bodyA, bodyB, stiff));
-    return static_cast<DistanceConstraint *>(constraints.back().get());
+    if (!bodyA || !bodyB)
+        return { ConstraintType::DISTANCE, ConstraintHandle::nullId, 0 };
+    return distanceConstraints.Add(DistanceConstraint(bodyA, bodyB, stiff));
 }
 
-PinConstraint *PhysicsWorld::CreatePinConstraint(RigidBody *body, const Vector2 &pin, float stiff)
+ConstraintHandle PhysicsWorld::CreatePinConstraint(RigidBody *body, const Vector2 &pin, float stiff)
 {
-    constraints.emplace_back(std::make_unique<PinConstraint>(body, pin, stiff));
-    return static_cast<PinConstraint *>(constraints.back().get());
+    if (!body)
+        return { ConstraintType::PIN, ConstraintHandle::nullId, 0 };
+    return pinConstraints.Add(PinConstraint(body, pin, stiff));
+}
+
+bool PhysicsWorld::SetConstraintCompliance(const ConstraintHandle &handle, float compliance)
+{
+    // Conta solo con SetXpbdSubsteps > 0, in PBD vale stiffness
+    if (handle.type == ConstraintType::DISTANCE) {
+        DistanceConstraint *constraint = distanceConstraints.Get(handle);
+        if (constraint)
+            constraint->compliance = std::max(compliance, 0.0f);
+        return constraint != nullptr;
+    }
+    PinConstraint *constraint = pinConstraints.Get(handle);
+    if (constraint)
+        constraint->compliance = std::max(compliance, 0.0f);
+    return constraint != nullptr;
+}
+
+bool PhysicsWorld::RemoveConstraint(const ConstraintHandle &handle)
+{
+    if (handle.type == ConstraintType::DISTANCE)
+        return distanceConstraints.Remove(handle);
+    return pinConstraints.Remove(handle);
+}
+
+void PhysicsWorld::RemoveRigidBody(RigidBody *body)
+{
+    // Prima i vincoli che puntano al corpo, poi il corpo
+    distanceConstraints.RemoveIf([body](const DistanceConstraint &c) { return c.particleA == body || c.particleB == body; });
+    pinConstraints.RemoveIf([body](const PinConstraint &c) { return c.particleA == body; });
+
+    auto it = std::find_if(bodies.begin(), bodies.end(), [body](const std::unique_ptr<RigidBody> &b) { return b.get() == body; });
+    if (it == bodies.end())
+        return;
+
+    // Chi dormiva appoggiato al corpo deve ricadere: si sveglia il suo gruppo,
+    // che contiene le isole accanto, e ogni gruppo che lo aveva come appoggio.
+    // Senza guardare IsStatic: un appoggio reso dinamico e ancora nella lista
+    if (body->sleepGroup >= 0)
+        WakeGroup(body->sleepGroup);
+    WakeSupportedGroups(body);
+
+    bodies.erase(it);
+    broadphasePairs.clear();
+    pairBuckets.Clear();
+    contactCache.RemoveBody(body);
+    broadphaseDirty = true;
+}
+
+void PhysicsWorld::Clear()
+{
+    distanceConstraints.Clear();
+    pinConstraints.Clear();
+    bodies.clear();
+    broadphasePairs.clear();
+    pairBuckets.Clear();
+    contactCache.Clear();
+    sleepGroups.clear();
+    freeSleepGroups.clear();
+    sleepingBodyCount = 0;
+    broadphaseDirty = true;
 }
 
 void PhysicsWorld::SetGravity(const Vector2 &g)
@@ -40,6 +164,127 @@ void PhysicsWorld::SetTimeStep(float timeStep)
     fixedTimeStep = timeStep;
 }
 
+void PhysicsWorld::SetPersistentQuadTree(bool enabled)
+{
+    if (broadphaseType == BroadphaseType::QUADTREE)
+        static_cast<QuadTreeBroadphase *>(broadphase.get())->SetPersistent(enabled);
+    broadphaseDirty = true;
+}
+
+int PhysicsWorld::GetQuadTreeRelocations() const
+{
+    if (broadphaseType != BroadphaseType::QUADTREE)
+        return 0;
+    return static_cast<const QuadTreeBroadphase *>(broadphase.get())->GetRelocationCount();
+}
+
+void PhysicsWorld::SetSolverIterations(int iterations)
+{
+    solverIterations = std::max(1, iterations);
+}
+
+void PhysicsWorld::SetSolverTolerance(float tolerance)
+{
+    solverTolerance = std::max(0.0f, tolerance);
+}
+
+void PhysicsWorld::SetXpbdSubsteps(int substeps)
+{
+    xpbdSubsteps = std::max(0, substeps);
+}
+
+void PhysicsWorld::SetJacobiSolver(bool enabled, float relaxation)
+{
+    jacobiEnabled = enabled;
+    jacobiRelaxation = std::max(0.0f, relaxation);
+}
+
+void PhysicsWorld::SetChebyshevAcceleration(bool enabled, float spectralRadius, int warmupIterations)
+{
+    chebyshevEnabled = enabled;
+    chebyshevRadius = std::clamp(spectralRadius, 0.0f, 0.999f);
+    chebyshevWarmup = std::max(0, warmupIterations);
+}
+
+void PhysicsWorld::SetWarmStarting(bool enabled)
+{
+    warmStarting = enabled;
+}
+
+void PhysicsWorld::SetSolverThreads(int threads)
+{
+    if (threads <= 1)
+        threadPool.reset();
+    else if (!threadPool || threadPool->GetThreadCount() != static_cast<unsigned int>(threads))
+        threadPool = std::make_unique<ThreadPool>(threads);
+}
+
+void PhysicsWorld::SetCirclePruning(bool enabled)
+{
+    circlePruning = enabled;
+}
+
+void PhysicsWorld::SetConstraintBatching(bool enabled, bool fastInverseSqrt)
+{
+    constraintBatching = enabled;
+    batchFastInverseSqrt = fastInverseSqrt;
+}
+
+void PhysicsWorld::SetChainSolver(bool enabled)
+{
+    chainSolving = enabled;
+}
+
+void PhysicsWorld::SetMultigridSolver(bool enabled)
+{
+    multigridSolving = enabled;
+}
+
+void PhysicsWorld::SetSleepingEnabled(bool enabled)
+{
+    sleepingEnabled = enabled;
+    if (!enabled) {
+        for (size_t i = 0; i < sleepGroups.size(); i++)
+            WakeGroup(static_cast<int>(i));
+    }
+}
+
+void PhysicsWorld::SetSleepParameters(float tolerance, float time)
+{
+    sleepTolerance = tolerance;
+    timeToSleep = time;
+}
+
+int PhysicsWorld::GetSolverThreads() const
+{
+    return threadPool ? static_cast<int>(threadPool->GetThreadCount()) : 1;
+}
+
+size_t PhysicsWorld::GetMultigridLevelCount() const
+{
+    size_t levels = 0;
+    for (const MultigridSolver *multigrid : islandMultigrids) {
+        if (multigrid)
+            levels = std::max(levels, multigrid->GetLevelCount());
+    }
+    return levels;
+}
+
+void PhysicsWorld::MarkStaticGeometryDirty()
+{
+    WakeSupportedGroups(nullptr);
+    staticsDirty = true;
+    broadphaseDirty = true;
+}
+
+void PhysicsWorld::SetBroadphaseMargin(float margin)
+{
+    broadphase->SetMargin(margin);
+    staticBroadphase->SetMargin(margin);
+    broadphaseDirty = true;
+    staticsDirty = true;
+}
+
 void PhysicsWorld::Update(float deltaTime)
 {
     timeAccumulator += deltaTime;
@@ -49,126 +294,1190 @@ void PhysicsWorld::Update(float deltaTime)
     }
 }
 
-void PhysicsWorld::Step()
+void PhysicsWorld::SyncBroadphase()
+{
+    // Dopo lo step il solver ha spostato i corpi oltre l'ultimo Update:
+    // una sola risincronizzazione serve tutte le query fino al prossimo step
+    if (!broadphaseDirty)
+        return;
+
+    ClassifyBodies();
+    broadphase->Update(dynamicBodies);
+    broadphaseDirty = false;
+}
+
+void PhysicsWorld::QueryBroadphase(const AABB &range, std::vector<RigidBody *> &found)
+{
+    SyncBroadphase();
+    broadphase->Query(range, found);
+    staticBroadphase->Query(range, found);  // Ogni corpo sta in una sola delle due strutture
+}
+
+void PhysicsWorld::ClassifyBodies()
 {
-    // 1. Applica gravità a tutti i corpi dinamici
+    dynamicBodies.clear();
+
+    // I corpi addormentati stanno con i statici: non si muovono e le coppie
+    // tra loro non servono. Confronta con l'ultima build: basta una differenza
+    // (aggiunto, rimosso, diventato statico, addormentato o sveglio) per aggiornare
+    size_t staticCount = 0;
+    bool staticsChanged = false;
     for (auto &body : bodies) {
-        if (!body->IsStatic() && body->isActive) {
-            body->ApplyForce(gravity * body->mass);
+        if (!body->IsStatic() && !body->isSleeping) {
+            dynamicBodies.push_back(body.get());
+            continue;
         }
+        if (staticCount >= staticBodies.size() || staticBodies[staticCount] != body.get())
+            staticsChanged = true;
+        staticCount++;
     }
 
-    // 2. Integra movimento (Verlet)
-    for (auto &body : bodies) {
-        if (body->IsStatic() || !body->isActive)
+    if (staticsChanged || staticCount != staticBodies.size()) {
+        staticBodies.clear();
+        for (auto &body : bodies) {
+            if (body->IsStatic() || body->isSleeping)
+                staticBodies.push_back(body.get());
+        }
+        staticsDirty = true;
+    }
+
+    if (staticsDirty) {
+        staticBroadphase->Update(staticBodies);
+        staticsDirty = false;
+    }
+}
+
+void PhysicsWorld::PruneCirclePairs()
+{
+    // Filtro del broadphase, non narrowphase: le coppie cerchio-cerchio passano
+    // tutte insieme dal test SIMD sulla distanza e restano solo quelle entro il
+    // margine di entrambi i corpi, cioe quelle che il solver puo ancora far
+    // toccare in questo step. Il contatto lo ricalcola il solver a ogni iterazione.
+    std::vector<BroadphasePair> &circles = pairBuckets.Get(ShapeType::CIRCLE, ShapeType::CIRCLE);
+    if (circles.empty())
+        return;
+
+    circleBatch.Clear();
+    for (const auto &pair : circles)
+        circleBatch.Add(pair.bodyA, pair.bodyB);
+
+    CircleBatchKernel::Prune(circleBatch, circleLanes, 2.0f * broadphase->GetMargin());
+
+    // Corsie in ordine crescente: compattazione sul posto
+    for (size_t i = 0; i < circleLanes.size(); i++)
+        circles[i] = circles[circleLanes[i]];
+    circles.resize(circleLanes.size());
+}
+
+void PhysicsWorld::FindStaticPairs()
+{
+    // Solo dinamico contro statico: le coppie statico-statico non servono
+    float margin = broadphase->GetMargin();
+    for (RigidBody *body : dynamicBodies) {
+        staticCandidates.clear();
+        staticBroadphase->Query(Broadphase::GetBodyBounds(body, margin), staticCandidates);
+
+        for (RigidBody *other : staticCandidates) {
+            if (body < other)
+                broadphasePairs.push_back({ body, other });
+            else
+                broadphasePairs.push_back({ other, body });
+        }
+    }
+}
+
+bool PhysicsWorld::SolveContinuousCollisions(std::vector<CollisionInfo> &collisions)
+{
+    bool moved = false;
+    for (RigidBody *body : dynamicBodies) {
+        if (!body->isContinuous || !body->isActive)
+            continue;
+
+        // Sotto la mezza dimensione minima del corpo il centro non puo
+        // attraversare nemmeno un muro sottilissimo: basta la collisione discreta
+        Vector2 from = body->oldPosition;
+        Vector2 to = body->position;
+        Vector2 d = to - from;
+        float extent = body->shapeType == ShapeType::CIRCLE ? body->radius : 0.5f * std::min(body->width, body->height);
+        if (d.LengthSquared() <= extent * extent)
+            continue;
+
+        // Candidati: tutto cio che tocca l'AABB spazzato dal corpo
+        AABB bounds = Broadphase::GetBodyBounds(body, 0.0f);
+        AABB swept((from + to) * 0.5f, bounds.halfWidth + std::fabs(d.x) * 0.5f, bounds.halfHeight + std::fabs(d.y) * 0.5f);
+        continuousCandidates.clear();
+        broadphase->Query(swept, continuousCandidates);
+        staticBroadphase->Query(swept, continuousCandidates);
+
+        RaycastHit hit;
+        bool found = false;
+        for (RigidBody *other : continuousCandidates) {
+            RaycastHit candidate;
+            if (other != body && CollisionDetection::SweepBody(body, from, to, other, candidate) && (!found || candidate.fraction < hit.fraction)) {
+                hit = candidate;
+                found = true;
+            }
+        }
+        if (!found)
             continue;
 
-        body->Integrate(fixedTimeStep);
+        // Fermo al primo impatto con la velocita intera: la restituzione di
+        // fine step la riflette come per un contatto discreto
+        body->position = hit.point;
+        body->oldPosition = hit.point - d;
+        if (hit.body->isSleeping)
+            WakeBody(hit.body);
+        collisions.push_back({ hit.body, body, hit.normal, 0.0f, true });
+        moved = true;
     }
+    return moved;
+}
 
-    // 3. Risolvi collisioni (position constraints)
-    std::vector<CollisionInfo> collisions;
-    const int solverIterations = 5;
-    
-    for (int iteration = 0; iteration < solverIterations; iteration++) {
-        if (iteration == 0) {
-            quadTree->Clear();
-            for (auto &body : bodies) {
-                quadTree->Insert(body.get());
+void PhysicsWorld::FindAllPairs()
+{
+    broadphase->FindPairs(broadphasePairs);
+    FindStaticPairs();
+    pairBuckets.Build(broadphasePairs);
+    if (circlePruning)
+        PruneCirclePairs();
+}
+
+void PhysicsWorld::WakeBody(RigidBody *body)
+{
+    if (body->sleepGroup >= 0) {
+        WakeGroup(body->sleepGroup);
+        return;
+    }
+
+    body->isSleeping = false;
+    body->sleepTime = 0.0f;
+}
+
+void PhysicsWorld::WakeGroup(int group)
+{
+    for (RigidBody *body : sleepGroups[group].bodies) {
+        body->isSleeping = false;
+        body->sleepGroup = -1;
+        body->sleepTime = 0.0f;
+        body->restPosition = body->position;
+    }
+
+    if (!sleepGroups[group].bodies.empty()) {
+        sleepingBodyCount -= sleepGroups[group].bodies.size();
+        sleepGroups[group].bodies.clear();
+        sleepGroups[group].supports.clear();
+        freeSleepGroups.push_back(group);
+        sleepingChanged = true;
+    }
+}
+
+void PhysicsWorld::WakeSupportedGroups(const RigidBody *support)
+{
+    for (size_t group = 0; group < sleepGroups.size(); group++) {
+        for (const SleepSupport &entry : sleepGroups[group].supports) {
+            bool affected;
+            if (support)
+                affected = entry.body == support;
+            else {
+                AABB bounds = Broadphase::GetBodyBounds(entry.body, 0.0f);
+                affected = !entry.body->IsStatic() || bounds.center != entry.bounds.center ||
+                    bounds.halfWidth != entry.bounds.halfWidth || bounds.halfHeight != entry.bounds.halfHeight;
+            }
+            if (affected) {
+                WakeGroup(static_cast<int>(group));
+                break;
             }
         }
+    }
+}
 
-        // Usa QuadTree invece del doppio loop
-        for (auto &body : bodies) {
-            std::set<RigidBody *> nearby;
-
-            // Crea AABB di query (espandi un po' per sicurezza)
-            float baseSize = body->shapeType == ShapeType::CIRCLE ?
-                body->radius * 2.0f :
-                std::max(body->width, body->height);
-
-            // Trova dimensione massima nel mondo
-            float maxSize = 5.0f;  // Default
-            for (auto &b : bodies) {
-                float size = b->shapeType == ShapeType::CIRCLE ?
-                    b->radius : std::max(b->width, b->height);
-                maxSize = std::max(maxSize, size);
+void PhysicsWorld::MergeSleepGroup(int from, int into)
+{
+    SleepGroup &source = sleepGroups[from];
+    SleepGroup &target = sleepGroups[into];
+    for (RigidBody *body : source.bodies) {
+        body->sleepGroup = into;
+        target.bodies.push_back(body);
+    }
+    target.supports.insert(target.supports.end(), source.supports.begin(), source.supports.end());
+
+    source.bodies.clear();
+    source.supports.clear();
+    freeSleepGroups.push_back(from);
+}
+
+void PhysicsWorld::WakeDisturbedGroups()
+{
+    // ApplyForce, SetPosition e SetVelocity svegliano un corpo solo: qui tocca al suo gruppo
+    for (size_t group = 0; group < sleepGroups.size(); group++) {
+        for (RigidBody *body : sleepGroups[group].bodies) {
+            if (!body->isSleeping) {
+                WakeGroup(static_cast<int>(group));
+                break;
             }
+        }
+    }
+}
 
-            float querySize = baseSize + maxSize;
-            AABB queryRange(body->position, querySize, querySize);
+void PhysicsWorld::WakeTouchedBodies()
+{
+    // Coppie sveglio-addormentato: arrivano solo da FindStaticPairs. Serve un
+    // contatto vero, non basta l'AABB allargata del margine
+    pairBuckets.ForEachPair([&](const BroadphasePair &pair, size_t) {
+        if (pair.bodyA->isSleeping == pair.bodyB->isSleeping)
+            return;
 
-            quadTree->Query(queryRange, nearby);
+        CollisionInfo info;
+        if (PairBuckets::Detect(pair, info))
+            WakeBody(pair.bodyA->isSleeping ? pair.bodyA : pair.bodyB);
+    });
 
-            for (auto *other : nearby) {
-                if (body.get() >= other) continue;  // Evita duplicati e self-check
+    // Vincolo tra un corpo sveglio che si muove e uno addormentato
+    for (const DistanceConstraint &constraint : distanceConstraints.GetItems()) {
+        RigidBody *a = constraint.particleA;
+        RigidBody *b = constraint.particleB;
+        if (a->isSleeping == b->isSleeping)
+            continue;
 
-                CollisionInfo info;
-                bool collided = DetectCollision(body.get(), other, info);
-                if (collided) {
-                    if (iteration == 0) {
-                        collisions.push_back(info);
-                    }
-                    SolvePositionConstraint(info);
-                }
+        RigidBody *awake = a->isSleeping ? b : a;
+        if (!awake->IsStatic())
+            WakeBody(a->isSleeping ? a : b);
+    }
+}
+
+void PhysicsWorld::UpdateSleeping()
+{
+    if (!sleepingEnabled)
+        return;
+
+    // Fermo = entro sleepTolerance dalla posizione di riposo. La velocita di
+    // Verlet non serve: in un appoggio le correzioni spostano anche oldPosition
+    // e resta una velocita apparente anche con il corpo immobile.
+    const auto &islandBodies = islandBuilder.GetBodies();
+    const auto &islandPairs = islandBuilder.GetPairs();
+    float tolerance2 = sleepTolerance * sleepTolerance;
+
+    for (const Island &island : islandBuilder.GetIslands()) {
+        float minSleepTime = timeToSleep;
+        for (size_t i = island.bodyBegin; i < island.bodyEnd; i++) {
+            RigidBody *body = islandBodies[i];
+            if ((body->position - body->restPosition).LengthSquared() > tolerance2) {
+                body->restPosition = body->position;
+                body->sleepTime = 0.0f;
+            }
+            else {
+                body->sleepTime += fixedTimeStep;
+            }
+            minSleepTime = std::min(minSleepTime, body->sleepTime);
+        }
+
+        if (minSleepTime < timeToSleep)
+            continue;
+
+        // Tutta l'isola si addormenta insieme, ferma dove si trova. Le coppie
+        // verso corpi fissi dicono su cosa poggia: i gruppi gia addormentati
+        // vicini si uniscono al suo, i corpi statici diventano appoggi
+        int group = -1;
+        for (size_t i = island.pairBegin; i < island.pairEnd; i++) {
+            const BroadphasePair &pair = solverPairs[islandPairs[i]];
+            RigidBody *other = pair.bodyA->solverIndex == GraphColoring::fixedBody ? pair.bodyA : pair.bodyB;
+            if (other->sleepGroup < 0 || other->sleepGroup == group)
+                continue;
+            if (group < 0)
+                group = other->sleepGroup;
+            else
+                MergeSleepGroup(other->sleepGroup, group);
+        }
+
+        if (group < 0) {
+            if (!freeSleepGroups.empty()) {
+                group = freeSleepGroups.back();
+                freeSleepGroups.pop_back();
             }
+            else {
+                group = static_cast<int>(sleepGroups.size());
+                sleepGroups.emplace_back();
+            }
+        }
+
+        std::vector<SleepSupport> &supports = sleepGroups[group].supports;
+        for (size_t i = island.pairBegin; i < island.pairEnd; i++) {
+            const BroadphasePair &pair = solverPairs[islandPairs[i]];
+            RigidBody *other = pair.bodyA->solverIndex == GraphColoring::fixedBody ? pair.bodyA : pair.bodyB;
+            if (!other->IsStatic())
+                continue;
+            auto known = std::find_if(supports.begin(), supports.end(), [other](const SleepSupport &entry) { return entry.body == other; });
+            if (known == supports.end())
+                supports.push_back({ other, Broadphase::GetBodyBounds(other, 0.0f) });
+        }
+
+        for (size_t i = island.bodyBegin; i < island.bodyEnd; i++) {
+            RigidBody *body = islandBodies[i];
+            body->isSleeping = true;
+            body->sleepGroup = group;
+            body->oldPosition = body->position;
+            body->velocity = Vector2::ZERO;
+            sleepGroups[group].bodies.push_back(body);
+        }
+        sleepingBodyCount += island.GetBodyCount();
+    }
+}
+
+void PhysicsWorld::QueryPoint(const Vector2 &point, std::vector<RigidBody *> &results)
+{
+    results.clear();
+    QueryBroadphase(AABB(point, 0.0f, 0.0f), results);
+
+    results.erase(std::remove_if(results.begin(), results.end(),
+        [&](RigidBody *body) { return !CollisionDetection::PointInBody(point, body); }), results.end());
+}
+
+void PhysicsWorld::QueryAABB(const AABB &region, std::vector<RigidBody *> &results)
+{
+    results.clear();
+    QueryBroadphase(region, results);
+
+    results.erase(std::remove_if(results.begin(), results.end(),
+        [&](RigidBody *body) { return !CollisionDetection::AABBOverlapsBody(region, body); }), results.end());
+}
+
+void PhysicsWorld::QueryCircle(const Vector2 &center, float radius, std::vector<RigidBody *> &results)
+{
+    results.clear();
+    QueryBroadphase(AABB(center, radius, radius), results);
+
+    results.erase(std::remove_if(results.begin(), results.end(),
+        [&](RigidBody *body) { return !CollisionDetection::CircleOverlapsBody(center, radius, body); }), results.end());
+}
+
+bool PhysicsWorld::RayCast(const Vector2 &origin, const Vector2 &end, RaycastHit &hit)
+{
+    // Candidati: i corpi che toccano l'AABB del segmento
+    queryCandidates.clear();
+    QueryBroadphase(AABB((origin + end) * 0.5f, std::fabs(end.x - origin.x) * 0.5f, std::fabs(end.y - origin.y) * 0.5f), queryCandidates);
+
+    bool found = false;
+    for (RigidBody *body : queryCandidates) {
+        RaycastHit candidate;
+        if (CollisionDetection::RayVsBody(origin, end, body, candidate) && (!found || candidate.fraction < hit.fraction)) {
+            hit = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void PhysicsWorld::RayCastAll(const Vector2 &origin, const Vector2 &end, std::vector<RaycastHit> &hits)
+{
+    hits.clear();
+    queryCandidates.clear();
+    QueryBroadphase(AABB((origin + end) * 0.5f, std::fabs(end.x - origin.x) * 0.5f, std::fabs(end.y - origin.y) * 0.5f), queryCandidates);
+
+    for (RigidBody *body : queryCandidates) {
+        RaycastHit hit;
+        if (CollisionDetection::RayVsBody(origin, end, body, hit))
+            hits.push_back(hit);
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const RaycastHit &a, const RaycastHit &b) { return a.fraction < b.fraction; });
+}
+
+void PhysicsWorld::Step()
+{
+    // 0. Gruppi addormentati con un corpo svegliato da fuori (forza, SetPosition...)
+    if (sleepingBodyCount > 0)
+        WakeDisturbedGroups();
+
+    // 1. Applica gravità a tutti i corpi dinamici svegli
+    for (auto &body : bodies) {
+        if (!body->IsStatic() && body->isActive && !body->isSleeping) {
+            body->ApplyForce(gravity * body->mass);
         }
+    }
 
-        // Constraints
-        for (auto &constraint : constraints) {
-            constraint->Solve();
+    // 2. Integra movimento (Verlet). In XPBD serve solo a trovare le coppie
+    // di tutto lo step: SolveSubsteps riparte dalle posizioni salvate qui
+    if (xpbdSubsteps > 0) {
+        substepStarts.clear();
+        for (auto &body : bodies) {
+            if (!body->IsStatic() && body->isActive && !body->isSleeping)
+                substepStarts.push_back({ body.get(), body->position, body->oldPosition, body->angle, body->angularVelocity });
         }
     }
+    IntegrateBodies(fixedTimeStep);
 
-    // 4. Applica restituzione (rimbalzi)
+    // 3. Broadphase: una sola lista di coppie candidate per tutto lo step.
+    // La geometria statica ha una struttura sua, ricostruita solo se cambia.
+    std::vector<CollisionInfo> collisions;
+    ClassifyBodies();
+    sleepingChanged = false;
+    broadphase->Update(dynamicBodies);
+    // In XPBD niente CCD: ogni sottopasso sposta i corpi di una frazione dello step
+    if (xpbdSubsteps == 0 && SolveContinuousCollisions(collisions))
+        broadphase->Update(dynamicBodies);  // Corpi fermati all'impatto
+    FindAllPairs();
+
+    // Corpi addormentati toccati davvero: rientrano gia in questo step
+    if (sleepingBodyCount > 0)
+        WakeTouchedBodies();
+    if (sleepingChanged) {
+        ClassifyBodies();
+        broadphase->Update(dynamicBodies);
+        FindAllPairs();
+    }
+
+    // 4. Risolvi collisioni (position constraints)
+    contactCache.BeginStep(pairBuckets);
+    firstContacts.resize(pairBuckets.Size());
+    for (auto &info : firstContacts)
+        info.hasCollision = false;
+
+    // Isole indipendenti: ognuna col suo Gauss-Seidel e le sue iterazioni
+    BuildIslands();
+    if (xpbdSubsteps > 0)
+        SolveSubsteps();
+    else
+        SolveIslands();
+
+    // Contatti nuovi dello step in ordine di coppia: non dipende dai thread
+    for (const auto &info : firstContacts) {
+        if (info.hasCollision)
+            collisions.push_back(info);
+    }
+
+    // 5. Applica restituzione (rimbalzi)
     ApplyRestitution(collisions);
+    UpdateIslandStats();
+    UpdateSleeping();
+    contactCache.EndStep();
 
-    // 5. Pulisci forze accumulate
+    // 6. Pulisci forze accumulate
     for (auto &body : bodies) {
         body->ClearForces();
     }
+
+    broadphaseDirty = true;
+}
+
+void PhysicsWorld::IntegrateBodies(float dt)
+{
+    for (auto &body : bodies) {
+        if (body->IsStatic() || !body->isActive || body->isSleeping)
+            continue;
+
+        body->Integrate(dt);
+    }
 }
 
-bool PhysicsWorld::DetectCollision(RigidBody *a, RigidBody *b, CollisionInfo &info)
+void PhysicsWorld::SolveSubsteps()
 {
-    if (a->shapeType == ShapeType::CIRCLE && b->shapeType == ShapeType::CIRCLE) {
-        return CollisionDetection::CircleVsCircle(a, b, info);
+    float substep = fixedTimeStep / xpbdSubsteps;
+    xpbdInverseDt2 = 1.0f / (substep * substep);
+
+    // Di nuovo a inizio step, con oldPosition riscalata sul sottopasso: stessa
+    // velocita. I corpi svegliati dopo l'integrazione hanno solo la riscalatura.
+    for (const SubstepStart &start : substepStarts) {
+        start.body->position = start.position;
+        start.body->oldPosition = start.oldPosition;
+        start.body->angle = start.angle;
+        start.body->angularVelocity = start.angularVelocity;
     }
-    else if (a->shapeType == ShapeType::AABB && b->shapeType == ShapeType::AABB) {
-        return CollisionDetection::AABBvsAABB(a, b, info);
+    float toSubstep = 1.0f / xpbdSubsteps;
+    for (auto &body : bodies) {
+        if (!body->IsStatic() && body->isActive && !body->isSleeping)
+            body->oldPosition = body->position - (body->position - body->oldPosition) * toSubstep;
     }
-    else {
-        if (a->shapeType == ShapeType::CIRCLE)
-            return CollisionDetection::CircleVsAABB(a, b, info);
+
+    for (int step = 0; step < xpbdSubsteps; step++) {
+        IntegrateBodies(substep);
+
+        // Moltiplicatori da zero a ogni sottopasso (una sola iterazione)
+        for (size_t i = 0; i < distanceConstraints.Size(); i++)
+            distanceConstraints[i].lambda = 0.0f;
+        for (size_t i = 0; i < pinConstraints.Size(); i++)
+            pinConstraints[i].lambda = 0.0f;
+
+        SolveIslands();
+    }
+
+    // oldPosition di nuovo su fixedTimeStep per restituzione, sleeping e rendering
+    for (auto &body : bodies) {
+        if (!body->IsStatic() && body->isActive && !body->isSleeping)
+            body->oldPosition = body->position - (body->position - body->oldPosition) * static_cast<float>(xpbdSubsteps);
+    }
+}
+
+void PhysicsWorld::WarmStartContact(const CollisionInfo &info, size_t pairIndex)
+{
+    // I contatti gia toccati nello step precedente ripartono dalla correzione
+    // totale di allora: uno stack a riposo e quasi risolto prima delle iterazioni.
+    // Solo coppie che si toccano ancora, cosi un corpo che si stacca non viene spinto.
+    const float warmStartFactor = 0.8f;
+
+    const CachedContact *cached = contactCache.GetContact(pairIndex);
+    if (!cached || cached->previous <= 0.0f)
+        return;
+
+    // Faccia di contatto cambiata: si riparte da freddo
+    if (cached->normal.Dot(info.normal) < 0.95f)
+        return;
+
+    CollisionInfo warm = info;
+    warm.normal = cached->normal;
+    // Mai oltre la compenetrazione attuale: la correzione ripresa non deve
+    // staccare la coppia e schiacciare i vicini (in un mucchio diverge)
+    warm.penetration = std::min(cached->previous * warmStartFactor, info.penetration);
+    if (contactCache.Accumulate(pairIndex, warm, warm.penetration))
+        firstContacts[pairIndex] = info;
+    // Toccata anche nello step prima: contatto a riposo, vedi SolveContact
+    SolvePositionConstraint(warm, false);
+}
+
+float PhysicsWorld::SolveContact(const CollisionInfo &info, size_t pairIndex, bool firstIteration)
+{
+    if (contactCache.Accumulate(pairIndex, info, info.penetration) && firstIteration)
+        firstContacts[pairIndex] = info;
+    // Solo all'urto la correzione tiene la velocita (la restituzione la ribalta).
+    // Su un contatto a riposo la toglie: altrimenti a ogni step il corpo
+    // rientra della stessa quantita e un mucchio sta fermo solo se le
+    // iterazioni la smaltiscono tutta, cioe solo in certi ordini di soluzione.
+    SolvePositionConstraint(info, !contactCache.IsResting(pairIndex));
+    return info.penetration;
+}
+
+float PhysicsWorld::SolveConstraint(unsigned int index)
+{
+    size_t distanceCount = distanceConstraints.Size();
+    if (xpbdSubsteps > 0) {
+        if (index < distanceCount)
+            return distanceConstraints[index].SolveXpbd(xpbdInverseDt2);
+        return pinConstraints[index - distanceCount].SolveXpbd(xpbdInverseDt2);
+    }
+    if (index < distanceCount)
+        return distanceConstraints[index].Solve();
+    return pinConstraints[index - distanceCount].Solve();
+}
+
+template <typename Solver>
+void PhysicsWorld::AssignIslandSolvers(std::unordered_map<unsigned int, Solver> &solvers, std::vector<Solver *> &islandSolvers, bool enabled)
+{
+    // Solo isole PBD grandi. Chiave = primo vincolo dell'isola: finche l'isola
+    // non cambia, lo step dopo ritrova lo stesso solver e la sua cache.
+    const auto &islands = islandBuilder.GetIslands();
+    const auto &islandConstraints = islandBuilder.GetConstraints();
+    islandSolvers.assign(islands.size(), nullptr);
+    islandSolverKeys.clear();
+    if (enabled && xpbdSubsteps == 0 && !jacobiEnabled) {
+        for (size_t i = 0; i < islands.size(); i++) {
+            if (islands[i].GetConstraintCount() < coloredIslandItems)
+                continue;
+            unsigned int key = islandConstraints[islands[i].constraintBegin];
+            islandSolvers[i] = &solvers[key];
+            islandSolverKeys.push_back(key);
+        }
+    }
+
+    // Isole sparite, divise o fuse con altre: i loro solver non servono piu
+    std::sort(islandSolverKeys.begin(), islandSolverKeys.end());
+    for (auto it = solvers.begin(); it != solvers.end();) {
+        if (std::binary_search(islandSolverKeys.begin(), islandSolverKeys.end(), it->first))
+            ++it;
         else
-            return CollisionDetection::CircleVsAABB(b, a, info);
+            it = solvers.erase(it);
     }
 }
 
-void PhysicsWorld::SolvePositionConstraint(const CollisionInfo &info)
+void PhysicsWorld::BuildIslands()
+{
+    // Nodi del grafo: solo i corpi che il solver puo spostare
+    int count = 0;
+    for (auto &body : bodies) {
+        bool fixed = (body->isStatic && body->inverseMass == 0.0f) || body->isSleeping;
+        body->solverIndex = fixed ? GraphColoring::fixedBody : count++;
+    }
+    solverNodeCount = count;
+    if (chebyshevEnabled)
+        chebyshevIterates.resize(count);
+
+    islandBuilder.Begin(count);
+    solverPairs.resize(pairBuckets.Size());
+    pairBuckets.ForEachPair([&](const BroadphasePair &pair, size_t index) {
+        solverPairs[index] = pair;
+        islandBuilder.AddPair(pair.bodyA->solverIndex, pair.bodyB->solverIndex);
+    });
+
+    // Indice dei vincoli: prima le distanze, poi i pin (vedi SolveConstraint)
+    for (const DistanceConstraint &constraint : distanceConstraints.GetItems())
+        islandBuilder.AddConstraint(constraint.particleA->solverIndex, constraint.particleB->solverIndex);
+    for (const PinConstraint &constraint : pinConstraints.GetItems())
+        islandBuilder.AddConstraint(constraint.particleA->solverIndex, GraphColoring::fixedBody);
+
+    // In XPBD le iterazioni sono i sottopassi: una per sottopasso
+    islandBuilder.Build(bodies, xpbdSubsteps > 0 ? 1 : solverIterations);
+
+    if (chainSolving && !jacobiEnabled) {
+        chainSolver.Build(distanceConstraints.Size() > 0 ? &distanceConstraints[0] : nullptr, distanceConstraints.Size(),
+            pinConstraints.Size() > 0 ? &pinConstraints[0] : nullptr, pinConstraints.Size(),
+            islandBuilder, solverNodeCount, xpbdSubsteps > 0);
+    }
+
+    // Solver per isola pronti qui, in serie: le isole non creano niente mentre si risolvono
+    AssignIslandSolvers(distanceBatches, islandBatches, constraintBatching);
+    for (DistanceBatchSolver *batch : islandBatches) {
+        if (batch)
+            batch->SetFastInverseSqrt(batchFastInverseSqrt);
+    }
+    AssignIslandSolvers(multigrids, islandMultigrids, multigridSolving);
+}
+
+void PhysicsWorld::SolveIslands()
+{
+    std::vector<Island> &islands = islandBuilder.GetIslands();
+    lastColorCount = 0;
+    if (jacobiEnabled) {
+        SolveJacobi();
+        return;
+    }
+    if (!threadPool) {
+        for (Island &island : islands)
+            SolveIsland(island);
+        return;
+    }
+
+    // Isole grandi una alla volta, a colori su tutti i thread; le piccole
+    // in parallelo tra loro, ognuna in serie sul suo thread
+    parallelIslands.clear();
+    for (size_t i = 0; i < islands.size(); i++) {
+        if (islands[i].GetItemCount() >= coloredIslandItems)
+            SolveIslandColored(islands[i]);
+        else if (islands[i].GetItemCount() > 0)
+            parallelIslands.push_back(i);
+    }
+
+    threadPool->ParallelFor(parallelIslands.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            SolveIsland(islands[parallelIslands[i]]);
+    }, 2);
+}
+
+void PhysicsWorld::SolveIsland(Island &island)
+{
+    const auto &pairs = islandBuilder.GetPairs();
+    const auto &islandConstraints = islandBuilder.GetConstraints();
+
+    // In XPBD niente warm start: la correzione salvata e di uno step intero, non di un sottopasso
+    bool warmStart = warmStarting && xpbdSubsteps == 0;
+    // Le coppie dell'isola sono in pairIndex crescenti: un tratto per bucket
+    const unsigned int *pairBegin = pairs.data() + island.pairBegin;
+    const unsigned int *pairEnd = pairs.data() + island.pairEnd;
+    if (warmStart)
+        pairBuckets.ForEachContact(pairBegin, pairEnd, [&](const CollisionInfo &info, size_t pairIndex) { WarmStartContact(info, pairIndex); });
+
+    // I vincoli dell'isola divisi per tipo, una volta per tutte le iterazioni.
+    // Con le catene, solo quelli che non ne fanno parte.
+    size_t islandIndex = &island - islandBuilder.GetIslands().data();
+    unsigned int firstPin = static_cast<unsigned int>(distanceConstraints.Size());
+    const unsigned int *constraintBegin = islandConstraints.data() + island.constraintBegin;
+    const unsigned int *constraintEnd = islandConstraints.data() + island.constraintEnd;
+    if (chainSolving)
+        chainSolver.GetLooseConstraints(islandIndex, constraintBegin, constraintEnd);
+    const unsigned int *pinBegin = std::lower_bound(constraintBegin, constraintEnd, firstPin);
+    size_t distanceCount = pinBegin - constraintBegin;
+    size_t pinCount = constraintEnd - pinBegin;
+    DistanceConstraint *distanceData = distanceCount > 0 ? &distanceConstraints[0] : nullptr;
+    PinConstraint *pinData = pinCount > 0 ? &pinConstraints[0] : nullptr;
+
+    // Lotti SIMD: colorati e impacchettati una volta, usati a ogni iterazione
+    bool xpbd = xpbdSubsteps > 0;
+    DistanceBatchSolver *batch = islandBatches[islandIndex];
+    bool batched = batch && !xpbd && distanceCount >= coloredIslandItems;
+    if (batched)
+        batch->Build(distanceData, constraintBegin, distanceCount, solverNodeCount);
+    MultigridSolver *multigrid = islandMultigrids[islandIndex];
+    bool hierarchical = multigrid && !xpbd && distanceCount >= coloredIslandItems;
+    if (hierarchical)
+        multigrid->Build(distanceData, constraintBegin, distanceCount);
+
+    RigidBody *const *bodyBegin = islandBuilder.GetBodies().data() + island.bodyBegin;
+    RigidBody *const *bodyEnd = islandBuilder.GetBodies().data() + island.bodyEnd;
+    bool accelerated = chebyshevEnabled && !xpbd && island.iterations > 1;
+    float omega = 1.0f;
+    if (accelerated)
+        BeginChebyshev(bodyBegin, bodyEnd, pairBegin, pairEnd);
+
+    island.iterationsUsed = 0;
+    island.residual = 0.0f;
+    for (int iteration = 0; iteration < island.iterations; iteration++) {
+        float residual = 0.0f;
+        pairBuckets.ForEachContact(pairBegin, pairEnd, [&](const CollisionInfo &info, size_t pairIndex) {
+            residual = std::max(residual, SolveContact(info, pairIndex, iteration == 0));
+        });
+
+        // Gli indici sono ordinati: prima tutte le distanze, poi tutti i pin.
+        // La correzione grossolana prima: la passata fine toglie l'errore locale.
+        if (hierarchical)
+            multigrid->Solve();
+        if (xpbd) {
+            residual = std::max(residual, DistanceConstraint::SolveXpbdBatch(distanceData, constraintBegin, distanceCount, xpbdInverseDt2));
+            residual = std::max(residual, PinConstraint::SolveXpbdBatch(pinData, pinBegin, pinCount, firstPin, xpbdInverseDt2));
+        }
+        else {
+            if (batched)
+                residual = std::max(residual, batch->Solve());
+            else
+                residual = std::max(residual, DistanceConstraint::SolveBatch(distanceData, constraintBegin, distanceCount));
+            residual = std::max(residual, PinConstraint::SolveBatch(pinData, pinBegin, pinCount, firstPin));
+        }
+
+        // Catene per ultime: a fine iterazione i loro anelli sono esatti
+        if (chainSolving)
+            residual = std::max(residual, chainSolver.Solve(islandIndex, xpbd ? xpbdInverseDt2 : 0.0f));
+
+        island.iterationsUsed = iteration + 1;
+        island.residual = residual;
+        if (residual < solverTolerance)
+            break;
+
+        if (accelerated) {
+            omega = ChebyshevOmega(iteration, omega);
+            ApplyChebyshev(bodyBegin, bodyEnd, omega);
+        }
+    }
+}
+
+void PhysicsWorld::SolveIslandColored(Island &island)
+{
+    // Elemento = pairIndex, oppure numero di coppie + indice del vincolo
+    const auto &pairs = islandBuilder.GetPairs();
+    const auto &islandConstraints = islandBuilder.GetConstraints();
+    unsigned int firstConstraint = static_cast<unsigned int>(solverPairs.size());
+
+    solverColoring.Begin(solverNodeCount);
+    for (size_t i = island.pairBegin; i < island.pairEnd; i++) {
+        const BroadphasePair &pair = solverPairs[pairs[i]];
+        solverColoring.Add(pairs[i], pair.bodyA->solverIndex, pair.bodyB->solverIndex);
+    }
+    // Con le catene, a colori solo i vincoli che non ne fanno parte
+    size_t islandIndex = &island - islandBuilder.GetIslands().data();
+    const unsigned int *constraintBegin = islandConstraints.data() + island.constraintBegin;
+    const unsigned int *constraintEnd = islandConstraints.data() + island.constraintEnd;
+    if (chainSolving)
+        chainSolver.GetLooseConstraints(islandIndex, constraintBegin, constraintEnd);
+
+    size_t distanceCount = distanceConstraints.Size();
+    for (const unsigned int *constraint = constraintBegin; constraint != constraintEnd; constraint++) {
+        unsigned int index = *constraint;
+        if (index < distanceCount) {
+            const DistanceConstraint &constraint = distanceConstraints[index];
+            solverColoring.Add(firstConstraint + index, constraint.particleA->solverIndex, constraint.particleB->solverIndex);
+        }
+        else {
+            solverColoring.Add(firstConstraint + index, pinConstraints[index - distanceCount].particleA->solverIndex, GraphColoring::fixedBody);
+        }
+    }
+    lastColorCount = std::max(lastColorCount, solverColoring.GetColorCount());
+
+    // Livelli grossolani sulle distanze dell'isola, in serie prima dei colori
+    const unsigned int *pinBegin = std::lower_bound(constraintBegin, constraintEnd, static_cast<unsigned int>(distanceCount));
+    MultigridSolver *multigrid = islandMultigrids[islandIndex];
+    bool hierarchical = multigrid && xpbdSubsteps == 0 && static_cast<size_t>(pinBegin - constraintBegin) >= coloredIslandItems;
+    if (hierarchical)
+        multigrid->Build(&distanceConstraints[0], constraintBegin, pinBegin - constraintBegin);
+
+    // Come in SolveIsland: in XPBD niente warm start
+    if (warmStarting && xpbdSubsteps == 0) {
+        auto warmStart = [&](const CollisionInfo &info, size_t pairIndex) { WarmStartContact(info, pairIndex); return 0.0f; };
+        SolveColored(warmStart, false);
+    }
+
+    // Chebyshev sui corpi dell'isola, a blocchi sui thread
+    const auto &islandBodies = islandBuilder.GetBodies();
+    bool accelerated = chebyshevEnabled && xpbdSubsteps == 0 && island.iterations > 1;
+    float omega = 1.0f;
+    if (accelerated)
+        BeginChebyshev(islandBodies.data() + island.bodyBegin, islandBodies.data() + island.bodyEnd, pairs.data() + island.pairBegin, pairs.data() + island.pairEnd);
+
+    island.iterationsUsed = 0;
+    island.residual = 0.0f;
+    for (int iteration = 0; iteration < island.iterations; iteration++) {
+        auto solveContact = [&](const CollisionInfo &info, size_t pairIndex) { return SolveContact(info, pairIndex, iteration == 0); };
+        if (hierarchical)
+            multigrid->Solve();
+        island.residual = SolveColored(solveContact, true);
+        // Le catene possono condividere gli estremi: in serie, dopo i colori
+        if (chainSolving)
+            island.residual = std::max(island.residual, chainSolver.Solve(islandIndex, xpbdSubsteps > 0 ? xpbdInverseDt2 : 0.0f));
+        island.iterationsUsed = iteration + 1;
+        if (island.residual < solverTolerance)
+            break;
+
+        if (accelerated) {
+            omega = ChebyshevOmega(iteration, omega);
+            threadPool->ParallelFor(island.GetBodyCount(), [&](size_t begin, size_t end) {
+                ApplyChebyshev(islandBodies.data() + island.bodyBegin + begin, islandBodies.data() + island.bodyBegin + end, omega);
+            });
+        }
+    }
+}
+
+float PhysicsWorld::ChebyshevOmega(int iteration, float omega) const
+{
+    // Alla prima iterazione non c'e ancora un'iterata precedente
+    if (iteration < std::max(chebyshevWarmup, 1))
+        return 1.0f;
+    float radius2 = chebyshevRadius * chebyshevRadius;
+    if (iteration == std::max(chebyshevWarmup, 1))
+        return 2.0f / (2.0f - radius2);
+    return 4.0f / (4.0f - radius2 * omega);
+}
+
+void PhysicsWorld::BeginChebyshev(RigidBody *const *begin, RigidBody *const *end, const unsigned int *pairBegin, const unsigned int *pairEnd)
+{
+    for (RigidBody *const *body = begin; body != end; body++) {
+        ChebyshevIterate &iterate = chebyshevIterates[(*body)->solverIndex];
+        iterate.previous = (*body)->position;
+        iterate.current = (*body)->position;
+        iterate.previousOld = (*body)->oldPosition;
+        iterate.currentOld = (*body)->oldPosition;
+        iterate.push = 1.0f;
+    }
+    for (const unsigned int *pair = pairBegin; pair != pairEnd; pair++) {
+        for (RigidBody *body : { solverPairs[*pair].bodyA, solverPairs[*pair].bodyB }) {
+            if (body->solverIndex >= 0)
+                chebyshevIterates[body->solverIndex].push = chebyshevContactPush;
+        }
+    }
+}
+
+void PhysicsWorld::ApplyChebyshev(RigidBody *const *begin, RigidBody *const *end, float omega)
+{
+    // x(k + 1) = x(k - 1) + omega * (risolta - x(k - 1)), per oldPosition uguale.
+    // La spinta dei vincoli diventa velocita come ogni correzione PBD; quella
+    // dei contatti che tengono la velocita sposta position e oldPosition insieme.
+    for (RigidBody *const *body = begin; body != end; body++) {
+        ChebyshevIterate &iterate = chebyshevIterates[(*body)->solverIndex];
+        float weight = (omega - 1.0f) * iterate.push;
+        if (weight != 0.0f) {
+            (*body)->position += ((*body)->position - iterate.previous) * weight;
+            (*body)->oldPosition += ((*body)->oldPosition - iterate.previousOld) * weight;
+        }
+        iterate.previous = iterate.current;
+        iterate.current = (*body)->position;
+        iterate.previousOld = iterate.currentOld;
+        iterate.currentOld = (*body)->oldPosition;
+    }
+}
+
+static void AtomicMax(std::atomic<float> &target, float value)
+{
+    float current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+template <typename ContactSolver>
+float PhysicsWorld::SolveColored(ContactSolver &solveContact, bool withConstraints)
+{
+    size_t pairCount = solverPairs.size();
+    std::atomic<float> maxResidual(0.0f);
+
+    // Un colore resta nell'ordine di inserimento: prima le coppie in pairIndex
+    // crescenti, poi i vincoli. Le coppie del blocco vanno ai kernel per bucket.
+    auto solveItems = [&](const std::vector<unsigned int> &items, size_t begin, size_t end) {
+        float residual = 0.0f;
+        const unsigned int *first = items.data() + begin;
+        const unsigned int *last = items.data() + end;
+        const unsigned int *constraints = std::lower_bound(first, last, static_cast<unsigned int>(pairCount));
+        pairBuckets.ForEachContact(first, constraints, [&](const CollisionInfo &info, size_t pairIndex) {
+            residual = std::max(residual, solveContact(info, pairIndex));
+        });
+        if (withConstraints) {
+            for (const unsigned int *item = constraints; item != last; item++)
+                residual = std::max(residual, SolveConstraint(*item - static_cast<unsigned int>(pairCount)));
+        }
+
+        AtomicMax(maxResidual, residual);  // Uno per blocco, non per elemento
+    };
+
+    for (size_t color = 0; color < solverColoring.GetColorCount(); color++) {
+        const auto &items = solverColoring.GetColor(color);
+        threadPool->ParallelFor(items.size(), [&](size_t begin, size_t end) { solveItems(items, begin, end); });
+    }
+
+    // Elementi rimasti senza colore: in serie, dopo tutti gli altri
+    const auto &overflow = solverColoring.GetOverflow();
+    solveItems(overflow, 0, overflow.size());
+    return maxResidual.load();
+}
+
+void PhysicsWorld::GetJacobiItemBodies(size_t item, RigidBody *&bodyA, RigidBody *&bodyB) const
+{
+    if (item < jacobiPairs.size()) {
+        const BroadphasePair &pair = solverPairs[jacobiPairs[item]];
+        bodyA = pair.bodyA;
+        bodyB = pair.bodyB;
+        return;
+    }
+
+    unsigned int index = islandBuilder.GetConstraints()[item - jacobiPairs.size()];
+    if (index < distanceConstraints.Size()) {
+        bodyA = distanceConstraints[index].particleA;
+        bodyB = distanceConstraints[index].particleB;
+    }
+    else {
+        bodyA = pinConstraints[index - distanceConstraints.Size()].particleA;
+        bodyB = nullptr;
+    }
+}
+
+void PhysicsWorld::SolveJacobi()
+{
+    // Elementi = coppie di tutte le isole, poi i loro vincoli. Le isole non
+    // servono: in Jacobi ogni elemento e indipendente dagli altri. Coppie in
+    // pairIndex crescenti, cosi un blocco si divide nei tratti dei bucket.
+    const auto &pairs = islandBuilder.GetPairs();
+    const auto &islandConstraints = islandBuilder.GetConstraints();
+    jacobiPairs.assign(pairs.begin(), pairs.end());
+    std::sort(jacobiPairs.begin(), jacobiPairs.end());
+    size_t pairCount = jacobiPairs.size();
+    size_t itemCount = pairCount + islandConstraints.size();
+    bool xpbd = xpbdSubsteps > 0;
+
+    // Per ogni corpo del solver gli elementi che lo toccano, in ordine: la
+    // somma non dipende dal numero di thread
+    jacobiBodies.resize(solverNodeCount);
+    for (auto &body : bodies) {
+        if (body->solverIndex >= 0)
+            jacobiBodies[body->solverIndex] = body.get();
+    }
+    jacobiOffsets.assign(solverNodeCount + 1, 0);
+    for (size_t item = 0; item < itemCount; item++) {
+        RigidBody *a, *b;
+        GetJacobiItemBodies(item, a, b);
+        if (a->solverIndex >= 0)
+            jacobiOffsets[a->solverIndex + 1]++;
+        if (b && b->solverIndex >= 0)
+            jacobiOffsets[b->solverIndex + 1]++;
+    }
+    for (int i = 0; i < solverNodeCount; i++)
+        jacobiOffsets[i + 1] += jacobiOffsets[i];
+    jacobiRefs.resize(jacobiOffsets[solverNodeCount]);
+    for (size_t item = 0; item < itemCount; item++) {
+        RigidBody *a, *b;
+        GetJacobiItemBodies(item, a, b);
+        unsigned int ref = static_cast<unsigned int>(item * 2);
+        if (a->solverIndex >= 0)
+            jacobiRefs[jacobiOffsets[a->solverIndex]++] = ref;
+        if (b && b->solverIndex >= 0)
+            jacobiRefs[jacobiOffsets[b->solverIndex]++] = ref + 1;
+    }
+    // Il riempimento ha spostato ogni offset all'inizio del corpo successivo
+    for (int i = solverNodeCount; i > 0; i--)
+        jacobiOffsets[i] = jacobiOffsets[i - 1];
+    jacobiOffsets[0] = 0;
+    jacobiCorrections.resize(itemCount);
+
+    int iterations = xpbd ? 1 : solverIterations;
+    int iterationsUsed = 0;
+    float residual = 0.0f;
+    RigidBody *const *bodyData = jacobiBodies.data();
+    bool accelerated = chebyshevEnabled && iterations > 1;
+    float omega = 1.0f;
+    if (accelerated)
+        BeginChebyshev(bodyData, bodyData + jacobiBodies.size(), jacobiPairs.data(), jacobiPairs.data() + pairCount);
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        std::atomic<float> maxResidual(0.0f);
+
+        // 1. Correzioni: legge le posizioni, scrive solo nel suo elemento
+        auto computeItems = [&](size_t begin, size_t end) {
+            float blockResidual = 0.0f;
+
+            // Coppie del blocco: il kernel chiama solo quelle in contatto, le
+            // altre restano spente scorrendo l'elemento fino al pairIndex
+            size_t pairEnd = std::min(end, pairCount);
+            size_t item = begin;
+            auto computeContact = [&](const CollisionInfo &info, size_t pairIndex) {
+                for (; jacobiPairs[item] != pairIndex; item++) {
+                    jacobiCorrections[item].contact = true;
+                    jacobiCorrections[item].active = false;
+                }
+                JacobiCorrection &correction = jacobiCorrections[item++];
+                correction.contact = true;
+                if (contactCache.Accumulate(pairIndex, info, info.penetration) && iteration == 0)
+                    firstContacts[pairIndex] = info;
+                correction.keepVelocity = !contactCache.IsResting(pairIndex);
+                correction.active = ComputeContactCorrection(info, correction.deltaA, correction.deltaB);
+                blockResidual = std::max(blockResidual, info.penetration);
+            };
+            if (item < pairEnd)
+                pairBuckets.ForEachContact(jacobiPairs.data() + item, jacobiPairs.data() + pairEnd, computeContact);
+            for (; item < pairEnd; item++) {
+                jacobiCorrections[item].contact = true;
+                jacobiCorrections[item].active = false;
+            }
+
+            // Vincoli del blocco
+            for (item = std::max(begin, pairCount); item < end; item++) {
+                JacobiCorrection &correction = jacobiCorrections[item];
+                float itemResidual = 0.0f;
+                correction.contact = false;
+                unsigned int index = islandConstraints[item - pairCount];
+                if (index < distanceConstraints.Size()) {
+                    DistanceConstraint &constraint = distanceConstraints[index];
+                    correction.active = xpbd
+                        ? constraint.ComputeXpbdCorrection(xpbdInverseDt2, correction.deltaA, correction.deltaB, itemResidual)
+                        : constraint.ComputeCorrection(correction.deltaA, correction.deltaB, itemResidual);
+                }
+                else {
+                    PinConstraint &constraint = pinConstraints[index - distanceConstraints.Size()];
+                    correction.active = xpbd
+                        ? constraint.ComputeXpbdCorrection(xpbdInverseDt2, correction.deltaA, itemResidual)
+                        : constraint.ComputeCorrection(correction.deltaA, itemResidual);
+                }
+                blockResidual = std::max(blockResidual, itemResidual);
+            }
+            AtomicMax(maxResidual, blockResidual);
+        };
+
+        // 2. Ogni corpo: media delle sue correzioni per il fattore di rilassamento
+        auto applyBodies = [&](size_t begin, size_t end) {
+            for (size_t node = begin; node < end; node++) {
+                Vector2 constraintSum = Vector2::ZERO;
+                Vector2 contactSum = Vector2::ZERO;
+                Vector2 velocitySum = Vector2::ZERO;
+                int count = 0;
+                for (unsigned int r = jacobiOffsets[node]; r < jacobiOffsets[node + 1]; r++) {
+                    const JacobiCorrection &correction = jacobiCorrections[jacobiRefs[r] >> 1];
+                    if (!correction.active)
+                        continue;
+                    const Vector2 &delta = (jacobiRefs[r] & 1) ? correction.deltaB : correction.deltaA;
+                    if (!correction.contact)
+                        constraintSum += delta;
+                    else {
+                        contactSum += delta;
+                        if (correction.keepVelocity)
+                            velocitySum += delta;
+                    }
+                    count++;
+                }
+                if (count == 0)
+                    continue;
+
+                // Sovrarilassamento solo sui vincoli: un contatto spinto oltre
+                // la separazione rimbalza su quello sotto e una pila non si ferma
+                float constraintWeight = jacobiRelaxation / count;
+                float contactWeight = std::min(jacobiRelaxation, 1.0f) / count;
+                RigidBody *body = jacobiBodies[node];
+                body->position += constraintSum * constraintWeight + contactSum * contactWeight;
+                body->oldPosition += velocitySum * contactWeight;
+            }
+        };
+
+        if (threadPool) {
+            threadPool->ParallelFor(itemCount, computeItems);
+            threadPool->ParallelFor(jacobiBodies.size(), applyBodies);
+        }
+        else {
+            computeItems(0, itemCount);
+            applyBodies(0, jacobiBodies.size());
+        }
+
+        residual = maxResidual.load();
+        iterationsUsed = iteration + 1;
+        if (residual < solverTolerance)
+            break;
+
+        if (accelerated) {
+            omega = ChebyshevOmega(iteration, omega);
+            auto accelerate = [&](size_t begin, size_t end) { ApplyChebyshev(bodyData + begin, bodyData + end, omega); };
+            if (threadPool)
+                threadPool->ParallelFor(jacobiBodies.size(), accelerate);
+            else
+                accelerate(0, jacobiBodies.size());
+        }
+    }
+
+    // Un solo sistema per tutto il mondo: ogni isola riporta i valori globali
+    for (Island &island : islandBuilder.GetIslands()) {
+        island.iterationsUsed = iterationsUsed;
+        island.residual = residual;
+    }
+}
+
+void PhysicsWorld::UpdateIslandStats()
+{
+    const auto &islands = islandBuilder.GetIslands();
+    const auto &pairs = islandBuilder.GetPairs();
+
+    islandStats.resize(islands.size());
+    lastIterations = 0;
+    lastResidual = 0.0f;
+    for (size_t i = 0; i < islands.size(); i++) {
+        const Island &island = islands[i];
+        size_t contactCount = 0;
+        for (size_t p = island.pairBegin; p < island.pairEnd; p++) {
+            if (contactCache.IsTouched(pairs[p]))
+                contactCount++;
+        }
+        islandStats[i] = { island.GetBodyCount(), island.GetPairCount(), contactCount, island.GetConstraintCount(),
+            island.iterationsUsed, island.residual };
+        lastIterations = std::max(lastIterations, island.iterationsUsed);
+        lastResidual = std::max(lastResidual, island.residual);
+    }
+}
+
+bool PhysicsWorld::ComputeContactCorrection(const CollisionInfo &info, Vector2 &deltaA, Vector2 &deltaB) const
+{
+    // Stessa correzione di SolvePositionConstraint, restituita invece che applicata
+    if (info.bodyA->isStatic && info.bodyB->isStatic)
+        return false;
+
+    float inverseMassA = info.bodyA->isSleeping ? 0.0f : info.bodyA->inverseMass;
+    float inverseMassB = info.bodyB->isSleeping ? 0.0f : info.bodyB->inverseMass;
+    float totalInverseMass = inverseMassA + inverseMassB;
+    if (totalInverseMass == 0.0f)
+        return false;
+
+    bool movableA = !info.bodyA->isStatic && !info.bodyA->isSleeping;
+    bool movableB = !info.bodyB->isStatic && !info.bodyB->isSleeping;
+    deltaA = movableA ? info.normal * -((inverseMassA / totalInverseMass) * info.penetration) : Vector2::ZERO;
+    deltaB = movableB ? info.normal * ((inverseMassB / totalInverseMass) * info.penetration) : Vector2::ZERO;
+    return true;
+}
+
+void PhysicsWorld::SolvePositionConstraint(const CollisionInfo &info, bool keepVelocity)
 {
     if (info.bodyA->isStatic && info.bodyB->isStatic)
         return;
 
-    float totalInverseMass = info.bodyA->inverseMass + info.bodyB->inverseMass;
+    // Un corpo addormentato fa da appoggio fisso finche non viene svegliato
+    bool movableA = !info.bodyA->isStatic && !info.bodyA->isSleeping;
+    bool movableB = !info.bodyB->isStatic && !info.bodyB->isSleeping;
+    float inverseMassA = info.bodyA->isSleeping ? 0.0f : info.bodyA->inverseMass;
+    float inverseMassB = info.bodyB->isSleeping ? 0.0f : info.bodyB->inverseMass;
+
+    float totalInverseMass = inverseMassA + inverseMassB;
     if (totalInverseMass == 0.0f)
         return;
 
-    float correctionA = (info.bodyA->inverseMass / totalInverseMass) * info.penetration;
-    float correctionB = (info.bodyB->inverseMass / totalInverseMass) * info.penetration;
+    float correctionA = (inverseMassA / totalInverseMass) * info.penetration;
+    float correctionB = (inverseMassB / totalInverseMass) * info.penetration;
 
     Vector2 correctionVecA = info.normal * correctionA;
     Vector2 correctionVecB = info.normal * correctionB;
 
     // 🎯 Aggiorna ENTRAMBI position E oldPosition
-    if (!info.bodyA->isStatic) {
+    // (su un contatto a riposo solo position: la velocita verso il contatto sparisce)
+    if (movableA) {
         info.bodyA->position -= correctionVecA;
-        info.bodyA->oldPosition -= correctionVecA;  // ✅ Mantiene velocità!
+        if (keepVelocity)
+            info.bodyA->oldPosition -= correctionVecA;  // ✅ Mantiene velocità!
     }
 
-    if (!info.bodyB->isStatic) {
+    if (movableB) {
         info.bodyB->position += correctionVecB;
-        info.bodyB->oldPosition += correctionVecB;  // ✅ Mantiene velocità!
+        if (keepVelocity)
+            info.bodyB->oldPosition += correctionVecB;  // ✅ Mantiene velocità!
     }
 }
 
@@ -187,19 +1496,25 @@ void PhysicsWorld::ApplyRestitution(const std::vector<CollisionInfo> &collisions
         if (velocityAlongNormal > 0)
             continue;
 
+        // Un corpo addormentato non rimbalza: massa infinita come un statico
+        float inverseMassA = bodyA->isSleeping ? 0.0f : bodyA->inverseMass;
+        float inverseMassB = bodyB->isSleeping ? 0.0f : bodyB->inverseMass;
+        if (inverseMassA + inverseMassB == 0.0f)
+            continue;
+
         float restitution = std::min(bodyA->restitution, bodyB->restitution);
         float j = -(1.0f + restitution) * velocityAlongNormal;
-        j /= (bodyA->inverseMass + bodyB->inverseMass);
+        j /= (inverseMassA + inverseMassB);
 
         Vector2 impulse = info.normal * j;
 
         // 🎯 CORREZIONE DEFINITIVA: Segni ORIGINALI erano giusti!
-        if (!bodyA->IsStatic()) {
-            bodyA->oldPosition += impulse * bodyA->inverseMass * fixedTimeStep;  // ✅
+        if (!bodyA->IsStatic() && !bodyA->isSleeping) {
+            bodyA->oldPosition += impulse * inverseMassA * fixedTimeStep;  // ✅
         }
 
-        if (!bodyB->IsStatic()) {
-            bodyB->oldPosition -= impulse * bodyB->inverseMass * fixedTimeStep;  // ✅
+        if (!bodyB->IsStatic() && !bodyB->isSleeping) {
+            bodyB->oldPosition -= impulse * inverseMassB * fixedTimeStep;  // ✅
         }
     }
 }
\ No newline at end of file
@@ -8,21 +8,23 @@ RigidBody::RigidBody()
     : shapeType(ShapeType::CIRCLE), position(Vector2::ZERO), velocity(Vector2::ZERO), acceleration(Vector2::ZERO),
     angle(0.0f), angularVelocity(0.0f), angularAcceleration(0.0f),
     mass(1.0f), radius(1.0f), width(1.0f), height(1.0f), inverseMass(1.0f), inertia(1.0f), inverseInertia(1.0f),
-    restitution(0.2f), friction(0.3f), isStatic(false), isActive(true), isSleeping(false),
-    forceAccumulator(Vector2::ZERO), torqueAccumulator(0.0f)
+    restitution(0.2f), friction(0.3f), isStatic(false), isActive(true), isSleeping(false), isContinuous(false),
+    forceAccumulator(Vector2::ZERO), torqueAccumulator(0.0f), solverIndex(-1), sleepTime(0.0f), sleepGroup(-1)
 {
     oldPosition = position;
+    restPosition = position;
 }
 
 RigidBody::RigidBody(Vector2 pos, float mass)
     : shapeType(ShapeType::CIRCLE), position(pos), velocity(Vector2::ZERO), acceleration(Vector2::ZERO),
     angle(0.0f), angularVelocity(0.0f), angularAcceleration(0.0f),
-    radius(1.0f), width(1.0f), height(1.0f), restitution(0.2f), friction(0.3f), isStatic(false), isActive(true), isSleeping(false),
-    forceAccumulator(Vector2::ZERO), torqueAccumulator(0.0f)
+    radius(1.0f), width(1.0f), height(1.0f), restitution(0.2f), friction(0.3f), isStatic(false), isActive(true), isSleeping(false), isContinuous(false),
+    forceAccumulator(Vector2::ZERO), torqueAccumulator(0.0f), solverIndex(-1), sleepTime(0.0f), sleepGroup(-1)
 {
     SetMass(mass);
     UpdateInertia();
     oldPosition = position;
+    restPosition = position;
 }
 
 void RigidBody::ApplyForce(const Vector2 &force)
@@ -107,6 +109,11 @@ void RigidBody::SetStatic(bool static_state)
     }
 }
 
+void RigidBody::SetContinuous(bool enabled)
+{
+    isContinuous = enabled;
+}
+
 void RigidBody::Integrate(float dt)
 {
     if (IsStatic()) return;
@@ -143,11 +150,13 @@ void RigidBody::ClearForces()
 void RigidBody::SetPosition(const Vector2 &pos)
 {
     position = pos;
+    isSleeping = false;  // Il mondo risveglia anche il resto del suo gruppo
 }
 
 void RigidBody::SetVelocity(const Vector2 &vel)
 {
     if (!isStatic) {
+        isSleeping = false;
         velocity = vel;
         oldPosition = position - velocity * (1.0f / 60.0f);
     }
@@ -104,31 +104,24 @@ void SFMLRenderer::DrawWorld(const PhysicsWorld &world)
     }
     
     // Disegna constraints
-    const auto &constraints = world.GetConstraints();
-    for (const auto &c : constraints) {
-        if (c->IsValid()) {
-            Vector2 pointA = c->GetParticleA()->position;
-            Vector2 pointB = c->GetParticleB() ? c->GetParticleB()->position : c->GetPin();
-            DrawLine(pointA, pointB, sf::Color(100, 100, 100));
-        }
-    }
+    for (const DistanceConstraint &c : world.GetDistanceConstraints())
+        DrawLine(c.particleA->position, c.particleB->position, sf::Color(100, 100, 100));
 
     // Disegna i pin dei constraint
-    for (const auto &c : constraints) {
-        Vector2 pin = c->GetPin();
-        if (pin != Vector2::ZERO) {  // È un PinConstraint
-            sf::Vector2f screenPin = WorldToScreen(pin);
-
-            // Quadratino
-            float pinSize = 0.3f;  // dimensione mondo
-            float screenSize = (window.getView().getSize().x / worldWidth) * pinSize;
-
-            sf::RectangleShape pinSquare(sf::Vector2f(screenSize, screenSize));
-            pinSquare.setOrigin(sf::Vector2f(screenSize / 2, screenSize / 2));
-            pinSquare.setFillColor(sf::Color::Yellow);
-            pinSquare.setPosition(screenPin);
-            window.draw(pinSquare);
-        }
+    for (const PinConstraint &c : world.GetPinConstraints()) {
+        DrawLine(c.particleA->position, c.pin, sf::Color(100, 100, 100));
+
+        sf::Vector2f screenPin = WorldToScreen(c.pin);
+
+        // Quadratino
+        float pinSize = 0.3f;  // dimensione mondo
+        float screenSize = (window.getView().getSize().x / worldWidth) * pinSize;
+
+        sf::RectangleShape pinSquare(sf::Vector2f(screenSize, screenSize));
+        pinSquare.setOrigin(sf::Vector2f(screenSize / 2, screenSize / 2));
+        pinSquare.setFillColor(sf::Color::Yellow);
+        pinSquare.setPosition(screenPin);
+        window.draw(pinSquare);
     }
 }
 
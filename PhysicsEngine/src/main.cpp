@@ -8,6 +8,9 @@
 #include "Constraints/DistanceConstraints.h"
 #include "Input/MouseHandler.h"
 #include <SFML/Graphics.hpp>
+#include <chrono>
+#include <thread>
+#include <cstring>
 
 void TestVector2()
 {
@@ -514,6 +517,7 @@ void TestChain()
 {
     PhysicsWorld world;
     SFMLRenderer renderer(800, 600, 20.0f, 15.0f, "Chain Test");
+    world.SetChainSolver(true);  // Catena rigida: una soluzione diretta invece di tante iterazioni
 
     std::vector<RigidBody *> particles;
     std::vector<DistanceConstraint> constraints;
@@ -589,6 +593,13 @@ void TestWeb()
     const int gridWidth = 12;
     const int gridHeight = 8;
 
+    // XPBD: cedevolezza per vincolo, indipendente dal passo e dalle iterazioni
+    // (le stiffness sotto valgono solo senza sottopassi)
+    world.SetXpbdSubsteps(10);
+    const float horizontalCompliance = 1e-4f;
+    const float verticalCompliance = 2e-4f;
+    const float diagonalCompliance = 1e-3f;
+
     std::vector<std::vector<RigidBody *>> grid(gridHeight, std::vector<RigidBody *>(gridWidth));
     //std::vector<DistanceConstraint> constraints;
 
@@ -612,22 +623,26 @@ void TestWeb()
     // Constraint ORIZZONTALI
     for (int row = 0; row < gridHeight; row++) {
         for (int col = 0; col < gridWidth - 1; col++) {
-            world.CreateDistanceConstraint(grid[row][col], grid[row][col + 1], 0.3f);
+            ConstraintHandle handle = world.CreateDistanceConstraint(grid[row][col], grid[row][col + 1], 0.3f);
+            world.SetConstraintCompliance(handle, horizontalCompliance);
         }
     }
 
     // Constraint VERTICALI (✅ CORRETTO)
     for (int row = 0; row < gridHeight - 1; row++) {
         for (int col = 0; col < gridWidth; col++) {
-            world.CreateDistanceConstraint(grid[row][col], grid[row + 1][col], 0.2f);
+            ConstraintHandle handle = world.CreateDistanceConstraint(grid[row][col], grid[row + 1][col], 0.2f);
+            world.SetConstraintCompliance(handle, verticalCompliance);
         }
     }
     
     // Constraint DIAGONALI
     for (int row = 0; row < gridHeight - 1; row++) {
         for (int col = 0; col < gridWidth - 1; col++) {
-            world.CreateDistanceConstraint(grid[row][col], grid[row + 1][col + 1], 0.1f);
-            world.CreateDistanceConstraint(grid[row][col + 1], grid[row + 1][col], 0.1f);
+            ConstraintHandle first = world.CreateDistanceConstraint(grid[row][col], grid[row + 1][col + 1], 0.1f);
+            ConstraintHandle second = world.CreateDistanceConstraint(grid[row][col + 1], grid[row + 1][col], 0.1f);
+            world.SetConstraintCompliance(first, diagonalCompliance);
+            world.SetConstraintCompliance(second, diagonalCompliance);
         }
     }
     
@@ -827,6 +842,7 @@ void TestDoublePendulum()
 {
     PhysicsWorld world;
     SFMLRenderer renderer(800, 600, 20.0f, 15.0f, "Double Pendulum");
+    world.SetChainSolver(true);  // Pin + distanza: una catena di due anelli
     MouseHandler mouseHandler(100.0f, 15.0f);
 
     // 🎯 Primo pin (ancoraggio)
@@ -881,6 +897,377 @@ void TestDoublePendulum()
     }
 }
 
+// Griglia stile TestWeb, piu grande: vincoli orizzontali, verticali e diagonali
+static void BuildClothGrid(PhysicsWorld &world, int gridWidth, int gridHeight)
+{
+    std::vector<RigidBody *> grid(gridWidth * gridHeight);
+    for (int row = 0; row < gridHeight; row++) {
+        for (int col = 0; col < gridWidth; col++) {
+            bool isPin = row == 0 && (col % 10 == 0 || col == gridWidth - 1);
+            RigidBody *particle = world.CreateRigidBody(Vector2(col * 0.5f, 60.0f - row * 0.5f), isPin ? 0.0f : 0.3f);
+            particle->radius = 0.1f;
+            grid[row * gridWidth + col] = particle;
+        }
+    }
+
+    for (int row = 0; row < gridHeight; row++) {
+        for (int col = 0; col < gridWidth; col++) {
+            RigidBody *p = grid[row * gridWidth + col];
+            if (col + 1 < gridWidth)
+                world.CreateDistanceConstraint(p, grid[row * gridWidth + col + 1], 0.3f);
+            if (row + 1 < gridHeight)
+                world.CreateDistanceConstraint(p, grid[(row + 1) * gridWidth + col], 0.2f);
+            if (col + 1 < gridWidth && row + 1 < gridHeight) {
+                world.CreateDistanceConstraint(p, grid[(row + 1) * gridWidth + col + 1], 0.1f);
+                world.CreateDistanceConstraint(grid[row * gridWidth + col + 1], grid[(row + 1) * gridWidth + col], 0.1f);
+            }
+        }
+    }
+}
+
+// Mucchio di palline in una vasca chiusa da tre pareti statiche
+static void BuildPile(PhysicsWorld &world, int count)
+{
+    RigidBody *floor = world.CreateRigidBody(Vector2(25.0f, -1.0f), 0.0f);
+    floor->SetAABB(50.0f, 2.0f);
+    RigidBody *left = world.CreateRigidBody(Vector2(-0.5f, 25.0f), 0.0f);
+    left->SetAABB(1.0f, 50.0f);
+    RigidBody *right = world.CreateRigidBody(Vector2(50.5f, 25.0f), 0.0f);
+    right->SetAABB(1.0f, 50.0f);
+
+    for (int i = 0; i < count; i++) {
+        RigidBody *ball = world.CreateRigidBody(Vector2(0.5f + (i % 100) * 0.49f, 0.5f + (i / 100) * 0.49f), 1.0f);
+        ball->radius = 0.2f;
+    }
+}
+
+static unsigned long long HashPositions(const PhysicsWorld &world)
+{
+    unsigned long long hash = 1469598103934665603ull;
+    for (const auto &body : world.GetBodies()) {
+        unsigned int bits[2];
+        std::memcpy(bits, &body->position, sizeof(bits));
+        hash = (hash ^ bits[0]) * 1099511628211ull;
+        hash = (hash ^ bits[1]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void BenchmarkParallelSolver()
+{
+    const int steps = 300;
+    std::vector<int> threadCounts = { 1, 2, 4 };
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware > 4)
+        threadCounts.push_back(hardware);
+
+    for (int scene = 0; scene < 2; scene++) {
+        double serialMs = 0.0;
+        unsigned long long coloredHash = 0;
+        std::cout << (scene == 0 ? "Cloth 100x100" : "Pile 4000") << std::endl;
+
+        for (int threads : threadCounts) {
+            PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+            if (scene == 0)
+                BuildClothGrid(world, 100, 100);
+            else
+                BuildPile(world, 4000);
+            world.SetSolverThreads(threads);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < steps; i++)
+                world.Step();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+
+            // A parita di colorazione il risultato non deve dipendere dai thread
+            unsigned long long hash = HashPositions(world);
+            bool deterministic = true;
+            if (threads == 1)
+                serialMs = ms;
+            else if (coloredHash == 0)
+                coloredHash = hash;
+            else
+                deterministic = hash == coloredHash;
+
+            std::cout << "  threads " << threads << ": " << ms << " ms/step, speedup " << serialMs / ms
+                << ", colori " << world.GetSolverColorCount() << (deterministic ? "" : "  NON DETERMINISTICO") << std::endl;
+        }
+    }
+}
+
+// Spostamento massimo di un corpo in uno step: a riposo quasi zero
+static float StepMotion(PhysicsWorld &world)
+{
+    std::vector<Vector2> before;
+    for (const auto &body : world.GetBodies())
+        before.push_back(body->position);
+    world.Step();
+
+    float motion = 0.0f;
+    for (size_t i = 0; i < before.size(); i++)
+        motion = std::max(motion, (world.GetBodies()[i]->position - before[i]).Length());
+    return motion;
+}
+
+// Un mucchio assestato deve stare fermo sia in serie sia a colori. Sleeping
+// spento: un corpo addormentato non si muove comunque.
+void TestPileAtRest()
+{
+    const float restMotion = 1e-3f;
+    for (int threads : { 1, 2 }) {
+        PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+        BuildPile(world, 1000);
+        world.SetSleepingEnabled(false);
+        world.SetSolverThreads(threads);
+        for (int i = 0; i < 300; i++)
+            world.Step();
+
+        float motion = StepMotion(world);
+        std::cout << "Pile 1000, threads " << threads << ": spostamento massimo " << motion << ", colori "
+            << world.GetSolverColorCount() << (motion < restMotion ? "  OK" : "  NON A RIPOSO") << std::endl;
+    }
+}
+
+// Lo stesso mucchio in Jacobi, anche con sovrarilassamento: il fattore
+// vale solo per i vincoli, i contatti devono assestarsi e addormentarsi
+void TestJacobiPileAtRest()
+{
+    const float restMotion = 1e-3f;
+    const int pileCount = 1000;
+    for (float relaxation : { 1.0f, 1.5f }) {
+        PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+        BuildPile(world, pileCount);
+        world.SetJacobiSolver(true, relaxation);
+        world.SetSolverThreads(2);
+        for (int i = 0; i < 600; i++)
+            world.Step();
+
+        float motion = StepMotion(world);
+        bool atRest = motion < restMotion && world.GetSleepingBodyCount() == static_cast<size_t>(pileCount);  // I corpi statici non contano
+        std::cout << "Pile " << pileCount << ", Jacobi " << relaxation << ": spostamento massimo " << motion << ", addormentati "
+            << world.GetSleepingBodyCount() << (atRest ? "  OK" : "  NON A RIPOSO") << std::endl;
+    }
+}
+
+// Colonna di palline addormentata su una mensola statica. L'ultima pallina
+// arriva quando le altre dormono gia e si ferma senza gravita appena sopra,
+// entro il margine: dorme come isola a parte, ma nello stesso gruppo.
+// Togliere o spostare la mensola deve far ricadere tutta la colonna.
+void TestSleepingSupports()
+{
+    const int columnCount = 4;
+    const float minDrop = 1.0f;
+    const float gap = 0.05f;  // Meno del margine del broadphase: la coppia resta candidata
+    for (int scene = 0; scene < 2; scene++) {
+        PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+        RigidBody *floor = world.CreateRigidBody(Vector2(0.0f, -1.0f), 0.0f);
+        floor->SetAABB(40.0f, 2.0f);
+        RigidBody *shelf = world.CreateRigidBody(Vector2(0.0f, 5.0f), 0.0f);
+        shelf->SetAABB(4.0f, 1.0f);
+
+        std::vector<RigidBody *> column;
+        for (int i = 0; i < columnCount - 1; i++) {
+            column.push_back(world.CreateRigidBody(Vector2(0.0f, 6.0f + i), 1.0f));
+            column.back()->radius = 0.5f;
+        }
+        for (int i = 0; i < 300; i++)
+            world.Step();
+
+        Vector2 gravity = world.GetGravity();
+        world.SetGravity(Vector2::ZERO);
+        column.push_back(world.CreateRigidBody(Vector2(0.0f, column.back()->position.y + 1.0f + gap), 1.0f));
+        column.back()->radius = 0.5f;
+        for (int i = 0; i < 300; i++)
+            world.Step();
+        world.SetGravity(gravity);
+        bool asleep = world.GetSleepingBodyCount() == column.size();
+
+        std::vector<float> heights;
+        for (RigidBody *ball : column)
+            heights.push_back(ball->position.y);
+
+        if (scene == 0)
+            world.RemoveRigidBody(shelf);
+        else {
+            shelf->position = Vector2(0.0f, 2.0f);
+            world.MarkStaticGeometryDirty();
+        }
+        for (int i = 0; i < 300; i++)
+            world.Step();
+
+        float drop = heights[0] - column[0]->position.y;
+        for (size_t i = 1; i < column.size(); i++)
+            drop = std::min(drop, heights[i] - column[i]->position.y);
+
+        bool fell = asleep && drop > minDrop;
+        std::cout << (scene == 0 ? "Mensola tolta" : "Mensola spostata") << ": addormentati prima " << (asleep ? "tutti" : "NON tutti")
+            << ", caduta minima " << drop << (fell ? "  OK" : "  COLONNA SOSPESA") << std::endl;
+    }
+}
+
+// Filtro SIMD delle coppie cerchio-cerchio: tempo per step con e senza, a
+// parita di scena. Senza filtro il solver prova tutte le coppie del broadphase.
+void BenchmarkCirclePruning()
+{
+    const int steps = 200;
+    for (int count : { 1000, 4000, 10000 }) {
+        std::cout << "Pile " << count << std::endl;
+        double unprunedMs = 0.0;
+
+        for (int pruning = 0; pruning < 2; pruning++) {
+            PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+            BuildPile(world, count);
+            world.SetSleepingEnabled(false);
+            world.SetCirclePruning(pruning == 1);
+            for (int i = 0; i < 100; i++)
+                world.Step();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < steps; i++)
+                world.Step();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+            if (pruning == 0)
+                unprunedMs = ms;
+
+            std::cout << "  " << (pruning ? "con filtro" : "senza filtro") << ": " << ms << " ms/step, speedup " << unprunedMs / ms
+                << ", coppie " << world.GetBroadphasePairCount() << std::endl;
+        }
+    }
+}
+
+// Errore medio relativo dei vincoli di distanza: quanto la stoffa si allunga
+static double MeanConstraintError(const PhysicsWorld &world)
+{
+    double error = 0.0;
+    for (const DistanceConstraint &c : world.GetDistanceConstraints())
+        error += std::abs((c.particleB->position - c.particleA->position).Length() - c.restLength) / c.restLength;
+    return error / world.GetDistanceConstraints().size();
+}
+
+void BenchmarkConstraintBatching()
+{
+    const int steps = 100;
+    const char *modes[] = { "scalare", "lotti SIMD", "lotti SIMD + rsqrt" };
+    std::cout << "SIMD: " << CpuFeatures::GetName(CpuFeatures::GetSimdLevel()) << std::endl;
+
+    for (int size : { 100, 150, 200 }) {
+        std::cout << "Cloth " << size << "x" << size << std::endl;
+        double scalarMs = 0.0;
+
+        for (int mode = 0; mode < 3; mode++) {
+            PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+            BuildClothGrid(world, size, size);
+            world.SetSleepingEnabled(false);
+            world.SetConstraintBatching(mode > 0, mode == 2);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < steps; i++)
+                world.Step();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+            if (mode == 0)
+                scalarMs = ms;
+
+            std::cout << "  " << modes[mode] << ": " << ms << " ms/step, speedup " << scalarMs / ms
+                << ", errore medio " << MeanConstraintError(world) << std::endl;
+        }
+    }
+}
+
+// Convergenza del solver a livelli contro il ciclo normale: errore medio
+// dei vincoli e punto piu basso della stoffa (a riposo: 60 - 99.5 = -39.5)
+void BenchmarkMultigrid()
+{
+    const int steps = 60;
+    const char *modes[] = { "normale", "multigrid" };
+    std::cout << "Cloth 200x200" << std::endl;
+
+    for (int iterations : { 5, 10, 20, 40, 80 }) {
+        for (int mode = 0; mode < 2; mode++) {
+            PhysicsWorld world(BroadphaseType::DYNAMIC_AABB_TREE);
+            BuildClothGrid(world, 200, 200);
+            world.SetSleepingEnabled(false);
+            world.SetSolverIterations(iterations);
+            world.SetMultigridSolver(mode == 1);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < steps; i++)
+                world.Step();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+
+            float lowest = 0.0f;
+            for (const auto &body : world.GetBodies())
+                lowest = std::min(lowest, body->position.y);
+            std::cout << "  " << iterations << " iterazioni, " << modes[mode] << ": errore medio " << MeanConstraintError(world)
+                << ", punto piu basso " << lowest << ", " << ms << " ms/step, livelli " << world.GetMultigridLevelCount() << std::endl;
+        }
+    }
+}
+
+// Compenetrazione massima tra cerchi (tutte le coppie: solo per le prove)
+static float MaxCirclePenetration(const PhysicsWorld &world)
+{
+    std::vector<const RigidBody *> circles;
+    for (const auto &body : world.GetBodies()) {
+        if (body->shapeType == ShapeType::CIRCLE)
+            circles.push_back(body.get());
+    }
+
+    float deepest = 0.0f;
+    for (size_t i = 0; i < circles.size(); i++) {
+        for (size_t j = i + 1; j < circles.size(); j++) {
+            float distance = (circles[i]->position - circles[j]->position).Length();
+            deepest = std::max(deepest, circles[i]->radius + circles[j]->radius - distance);
+        }
+    }
+    return deepest;
+}
+
+// Errore contro iterazioni, con e senza Chebyshev (raggio 0.9 predefinito):
+// errore medio dei vincoli di una stoffa 40x40 e compenetrazione massima di
+// un mucchio, mediati sulla seconda meta della prova. Chebyshev deve stare
+// sotto a parita di iterazioni, e il mucchio deve comunque fermarsi. Sul
+// mucchio 1% di tolleranza: dalle 40 iterazioni i contatti sono gia a regime.
+void BenchmarkChebyshev()
+{
+    const float restMotion = 1e-3f;
+    const double settledMargin = 1.01;
+    for (int iterations : { 5, 10, 20, 40 }) {
+        double clothError[2], pileError[2];
+        float pileMotion[2];
+        for (int accelerated = 0; accelerated < 2; accelerated++) {
+            PhysicsWorld cloth(BroadphaseType::DYNAMIC_AABB_TREE);
+            BuildClothGrid(cloth, 40, 40);
+            cloth.SetSleepingEnabled(false);
+            cloth.SetSolverIterations(iterations);
+            cloth.SetChebyshevAcceleration(accelerated == 1);
+            clothError[accelerated] = 0.0;
+            for (int i = 0; i < 120; i++) {
+                cloth.Step();
+                if (i >= 60)
+                    clothError[accelerated] += MeanConstraintError(cloth) / 60;
+            }
+
+            PhysicsWorld pile(BroadphaseType::DYNAMIC_AABB_TREE);
+            BuildPile(pile, 1000);
+            pile.SetSleepingEnabled(false);
+            pile.SetSolverIterations(iterations);
+            pile.SetChebyshevAcceleration(accelerated == 1);
+            pileError[accelerated] = 0.0;
+            for (int i = 0; i < 300; i++) {
+                pile.Step();
+                if (i >= 250)
+                    pileError[accelerated] += MaxCirclePenetration(pile) / 50;
+            }
+            pileMotion[accelerated] = StepMotion(pile);
+        }
+
+        bool faster = clothError[1] < clothError[0] && pileError[1] < pileError[0] * settledMargin;
+        std::cout << iterations << " iterazioni: stoffa " << clothError[0] << " -> " << clothError[1] << " (x" << clothError[0] / clothError[1]
+            << "), mucchio " << pileError[0] << " -> " << pileError[1] << " (x" << pileError[0] / pileError[1]
+            << "), spostamento a riposo " << pileMotion[1] << (faster && pileMotion[1] < restMotion ? "  OK" : "  NO") << std::endl;
+    }
+}
+
 int main()
 {
     //TestVector2();
@@ -904,6 +1291,14 @@ int main()
     //TestMouseInteraction();
     //TestRotationOnly();
     //TestPinConstraint();
+    //BenchmarkParallelSolver();
+    //TestPileAtRest();
+    //TestJacobiPileAtRest();
+    //TestSleepingSupports();
+    //BenchmarkCirclePruning();
+    //BenchmarkConstraintBatching();
+    //BenchmarkMultigrid();
+    //BenchmarkChebyshev();
     TestDoublePendulum();
     return 0;
 }
\ No newline at end of file